@@ -0,0 +1,319 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Host benchmarks for the animation engine. Engines run on a synthetic
+ * 60 Hz clock so every run steps the same frames; wall time is only
+ * used to measure. Exits non-zero if the batched easing kernels drift
+ * from the scalar reference functions. */
+
+#include "eXUI/animations.hpp"
+#include <retro_miscellaneous.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace eXUI;
+
+static uint64_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    allocations++;
+
+    if (void* ptr = malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+static constexpr int64_t FrameUsec = 16667;
+static int64_t fake_time = 1000000;
+
+static int64_t fake_clock()
+{
+    return fake_time;
+}
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct result
+{
+    double ns_per_frame;
+    double allocs_per_frame;
+};
+
+/* Runs `frames` frames of `step` on top of engine.update() */
+template <typename F>
+static result run_frames(AnimationEngine& engine, int frames, F step)
+{
+    uint64_t allocs_before = allocations;
+    uint64_t start         = now_ns();
+
+    for (int i = 0; i < frames; i++)
+    {
+        fake_time += FrameUsec;
+        step(i);
+        engine.update();
+    }
+
+    return {
+        (double)(now_ns() - start) / frames,
+        (double)(allocations - allocs_before) / frames,
+    };
+}
+
+static menu_animation_ctx_entry_t make_entry(float* subject, float target, float duration, int easing)
+{
+    menu_animation_ctx_entry_t entry;
+
+    entry.easing_enum  = (enum menu_animation_easing_type)easing;
+    entry.tag          = (uintptr_t)-1;
+    entry.duration     = duration;
+    entry.target_value = target;
+    entry.subject      = subject;
+    entry.cb           = nullptr;
+    entry.tick         = nullptr;
+    entry.userdata     = nullptr;
+
+    return entry;
+}
+
+static void bench_update(size_t count)
+{
+    AnimationEngine engine(fake_clock);
+    std::vector<float> subjects(count, 0.0f);
+    const int frames = 600;
+
+    /* Long tweens so the whole set stays live, cycling every easing type */
+    for (size_t i = 0; i < count; i++)
+    {
+        menu_animation_ctx_entry_t entry = make_entry(&subjects[i], 1000.0f, 1e9f, i % EASING_LAST);
+        engine.push(&entry);
+    }
+    engine.update();
+
+    result r = run_frames(engine, frames, [](int) {});
+
+    printf("update      %6zu tweens   %9.2f ns/tween/frame   %6.2f allocs/frame\n",
+        count, r.ns_per_frame / count, r.allocs_per_frame);
+}
+
+static void bench_churn(size_t count)
+{
+    AnimationEngine engine(fake_clock);
+    std::vector<float> subjects(count, 0.0f);
+    std::vector<menu_animation_handle_t> handles(count, MENU_ANIMATION_INVALID_HANDLE);
+    const int frames = 600;
+
+    /* Every frame, every subject gets its tween killed and pushed again,
+     * like a focus highlight following rapid scrolling */
+    result kill_push = run_frames(engine, frames, [&](int frame) {
+        for (size_t i = 0; i < count; i++)
+        {
+            menu_animation_ctx_entry_t entry = make_entry(&subjects[i], (float)(frame % 2 ? 0 : 100), 150.0f, EASING_OUT_QUAD);
+            engine.kill(handles[i]);
+            handles[i] = engine.push(&entry);
+        }
+    });
+
+    /* Same motion through in-place retargeting */
+    result retarget = run_frames(engine, frames, [&](int frame) {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!engine.retarget(handles[i], (float)(frame % 2 ? 0 : 100), 150.0f))
+            {
+                menu_animation_ctx_entry_t entry = make_entry(&subjects[i], (float)(frame % 2 ? 0 : 100), 150.0f, EASING_OUT_QUAD);
+                handles[i] = engine.push(&entry);
+            }
+        }
+    });
+
+    printf("kill+push   %6zu /frame   %9.2f ns/tween/frame   %6.2f allocs/frame\n",
+        count, kill_push.ns_per_frame / count, kill_push.allocs_per_frame);
+    printf("retarget    %6zu /frame   %9.2f ns/tween/frame   %6.2f allocs/frame\n",
+        count, retarget.ns_per_frame / count, retarget.allocs_per_frame);
+}
+
+static void bench_timers(size_t count)
+{
+    AnimationEngine engine(fake_clock);
+    std::vector<menu_timer_t> timers(count);
+    std::vector<float> subjects(count, 0.0f);
+    const int frames = 600;
+    uint64_t fired = 0;
+
+    /* Every frame restarts `count` timers and delays `count` tweens
+     * by up to two seconds */
+    result r = run_frames(engine, frames, [&](int frame) {
+        for (size_t i = 0; i < count; i++)
+        {
+            menu_timer_ctx_entry_t timer;
+            menu_animation_ctx_entry_t entry = make_entry(&subjects[i], (float)(frame + 1), 100.0f, EASING_LINEAR);
+
+            timer.duration = (float)((i * 37 + frame * 11) % 2000);
+            timer.cb       = [&fired](void*) { fired++; };
+            timer.tick     = nullptr;
+            timer.userdata = nullptr;
+
+            engine.timerStart(&timers[i], &timer);
+            engine.pushDelayed((unsigned)((i * 53 + frame * 7) % 2000), &entry);
+        }
+    });
+
+    printf("timers      %6zu /frame   %9.2f ns/timer/frame   %6.2f allocs/frame\n",
+        count * 2, r.ns_per_frame / (count * 2), r.allocs_per_frame);
+}
+
+static void bench_ticker()
+{
+    const int iterations = 20000;
+    const size_t len     = 40;
+    std::string str;
+    char buffer[PATH_MAX_LENGTH];
+    Ticker ticker;
+    uint64_t start, allocs_before;
+    size_t sink = 0;
+
+    for (int i = 0; i < 20; i++)
+        str += "Long localized title 긴 제목 ";
+
+    for (int type = 0; type < TICKER_TYPE_LAST; type++)
+    {
+        start         = now_ns();
+        allocs_before = allocations;
+
+        for (int i = 0; i < iterations; i++)
+        {
+            menu_animation_ctx_ticker_t t;
+
+            t.selected  = true;
+            t.len       = len;
+            t.idx       = i;
+            t.type_enum = (enum menu_animation_ticker_type)type;
+            t.s         = buffer;
+            t.str       = str.c_str();
+            t.spacer    = nullptr;
+
+            menu_animation_ticker(&t);
+            sink += buffer[0];
+        }
+
+        printf("ticker %-6s legacy       %9.2f ns/call          %6.2f allocs/call\n",
+            type == TICKER_TYPE_LOOP ? "loop" : "bounce",
+            (double)(now_ns() - start) / iterations,
+            (double)(allocations - allocs_before) / iterations);
+
+        ticker.setText(str);
+        start         = now_ns();
+        allocs_before = allocations;
+
+        for (int i = 0; i < iterations; i++)
+        {
+            ticker.update(i, len, true, (enum menu_animation_ticker_type)type);
+            sink += ticker.getSpans().count;
+        }
+
+        printf("ticker %-6s retained     %9.2f ns/call          %6.2f allocs/call\n",
+            type == TICKER_TYPE_LOOP ? "loop" : "bounce",
+            (double)(now_ns() - start) / iterations,
+            (double)(allocations - allocs_before) / iterations);
+    }
+
+    if (sink == 0)
+        printf("\n");
+}
+
+/* Compares the batched easing path against the scalar references */
+static bool check_easing()
+{
+    const float duration = 300.0f;
+    bool ok = true;
+
+    for (int type = 0; type < EASING_LAST; type++)
+    {
+        easing_cb reference = menu_animation_get_easing((enum menu_animation_easing_type)type);
+        float worst = 0.0f;
+
+        if (!reference)
+            continue;
+
+        for (int step = 1; step < 18; step++)
+        {
+            AnimationEngine engine(fake_clock);
+            std::vector<float> subjects(8, 10.0f);
+            float t;
+
+            for (size_t i = 0; i < subjects.size(); i++)
+            {
+                menu_animation_ctx_entry_t entry = make_entry(&subjects[i], 60.0f, duration, type);
+                engine.push(&entry);
+            }
+
+            engine.update();
+            fake_time += step * FrameUsec;
+            engine.update();
+            t = engine.getDeltaTime();
+
+            for (float value : subjects)
+                worst = fmaxf(worst, fabsf(value - reference(t, 10.0f, 50.0f, duration)));
+        }
+
+        if (worst > 1e-3f)
+        {
+            printf("easing %2d: max error %g against reference\n", type, worst);
+            ok = false;
+        }
+    }
+
+    printf("easing      batched vs reference: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    bool ok = check_easing();
+
+    bench_update(100);
+    bench_update(1000);
+    bench_update(10000);
+    bench_churn(100);
+    bench_churn(1000);
+    bench_timers(100);
+    bench_timers(1000);
+    bench_ticker();
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Prints a binary log written by Logger::openBinaryLog() as text, one
+ * line per record with its timestamp relative to the first record. */
+
+#include "eXUI/logger.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+using namespace eXUI;
+
+static const char* const level_names[] = { "ERROR", "WARNING", "INFO", "DEBUG" };
+
+static bool read_exact(FILE* file, void* out, size_t size)
+{
+    return fread(out, 1, size, file) == size;
+}
+
+int main(int argc, char** argv)
+{
+    std::unordered_map<uint32_t, std::string> formats;
+    char magic[4], payload[UINT16_MAX];
+    uint64_t first = 0, timestamp;
+    uint32_t version, id, records = 0;
+    uint16_t length;
+    uint8_t level;
+    bool truncated = false;
+    FILE* file;
+    int entry;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <log.bin>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!(file = fopen(argv[1], "rb")))
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (!read_exact(file, magic, sizeof(magic)) || memcmp(magic, "EXLB", 4) != 0 ||
+        !read_exact(file, &version, sizeof(version)) || version != 1)
+    {
+        fprintf(stderr, "%s: not a version 1 eXUI binary log\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    while ((entry = fgetc(file)) != EOF)
+    {
+        if (entry == 'S')
+        {
+            if (!read_exact(file, &id, sizeof(id)) || !read_exact(file, &length, sizeof(length)) ||
+                !read_exact(file, payload, length))
+            {
+                truncated = true;
+                break;
+            }
+
+            formats[id].assign(payload, length);
+        }
+        else if (entry == 'R')
+        {
+            if (!read_exact(file, &level, sizeof(level)) || !read_exact(file, &timestamp, sizeof(timestamp)) ||
+                !read_exact(file, &id, sizeof(id)) || !read_exact(file, &length, sizeof(length)) ||
+                !read_exact(file, payload, length))
+            {
+                truncated = true;
+                break;
+            }
+
+            auto format = formats.find(id);
+            if (format == formats.end())
+            {
+                fprintf(stderr, "record %u: unknown format id %u\n", records, id);
+                return EXIT_FAILURE;
+            }
+
+            if (!records)
+                first = timestamp;
+
+            printf("%12.6f %-7s %s\n", (timestamp - first) / 1e6,
+                level < 4 ? level_names[level] : "?",
+                Logger::formatDeferred(format->second.c_str(), payload, length).c_str());
+            records++;
+        }
+        else
+        {
+            fprintf(stderr, "unknown entry 0x%02x after %u records\n", entry, records);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* A short read inside a record also hits end of file, so feof()
+     * alone cannot tell a cut-off record from a clean end */
+    if (truncated || ferror(file))
+    {
+        fprintf(stderr, "truncated log after %u records\n", records);
+        return EXIT_FAILURE;
+    }
+
+    fclose(file);
+    return EXIT_SUCCESS;
+}
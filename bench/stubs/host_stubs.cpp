@@ -0,0 +1,213 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <switch.h>
+#include <nanovg_dk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+void diagAbortWithResult(Result res)
+{
+    fprintf(stderr, "diagAbortWithResult(0x%x)\n", (unsigned)res);
+    abort();
+}
+
+u64 armGetSystemTick(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return armNsToTicks((u64)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+static std::vector<unsigned char> host_font;
+
+Result plInitialize(PlServiceType service_type)
+{
+    return 0;
+}
+
+void plExit(void)
+{
+}
+
+/* Every shared font type maps to the same host font */
+Result plGetSharedFontByType(PlFontData* font, PlSharedFontType SharedFontType)
+{
+    if (host_font.empty())
+    {
+        const char* path = getenv("EXUI_HOST_FONT");
+        FILE* file;
+        long size;
+
+        if (!path)
+            path = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+
+        if (!(file = fopen(path, "rb")))
+        {
+            fprintf(stderr, "cannot open %s, point EXUI_HOST_FONT at a TTF file\n", path);
+            return 1;
+        }
+
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        host_font.resize(size);
+        if (fread(host_font.data(), 1, size, file) != (size_t)size)
+            host_font.clear();
+        fclose(file);
+
+        if (host_font.empty())
+            return 1;
+    }
+
+    font->type    = SharedFontType;
+    font->offset  = 0;
+    font->size    = (u32)host_font.size();
+    font->address = host_font.data();
+    return 0;
+}
+
+/* Null NanoVG backend */
+
+struct host_texture
+{
+    int w, h;
+};
+
+struct host_backend
+{
+    nvg::DkRenderer* renderer;
+    std::vector<host_texture> textures; /* image id - 1 */
+};
+
+static int host_render_create(void* uptr)
+{
+    return 1;
+}
+
+static int host_render_create_texture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+    host_backend* backend = (host_backend*)uptr;
+
+    backend->textures.push_back({ w, h });
+    return (int)backend->textures.size();
+}
+
+static int host_render_delete_texture(void* uptr, int image)
+{
+    return 1;
+}
+
+static int host_render_update_texture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+    return 1;
+}
+
+static int host_render_get_texture_size(void* uptr, int image, int* w, int* h)
+{
+    host_backend* backend = (host_backend*)uptr;
+
+    if (image < 1 || image > (int)backend->textures.size())
+        return 0;
+
+    *w = backend->textures[image - 1].w;
+    *h = backend->textures[image - 1].h;
+    return 1;
+}
+
+static void host_render_viewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+}
+
+static void host_render_cancel(void* uptr)
+{
+}
+
+static void host_render_flush(void* uptr)
+{
+    ((host_backend*)uptr)->renderer->flushes++;
+}
+
+static void host_render_fill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation,
+    NVGscissor* scissor, float fringe, const float* bounds, const NVGpath* paths, int npaths)
+{
+    nvg::DkRenderer* renderer = ((host_backend*)uptr)->renderer;
+    int i;
+
+    renderer->fills++;
+    for (i = 0; i < npaths; i++)
+        renderer->vertices += paths[i].nfill + paths[i].nstroke;
+}
+
+static void host_render_stroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation,
+    NVGscissor* scissor, float fringe, float strokeWidth, const NVGpath* paths, int npaths)
+{
+    nvg::DkRenderer* renderer = ((host_backend*)uptr)->renderer;
+    int i;
+
+    renderer->strokes++;
+    for (i = 0; i < npaths; i++)
+        renderer->vertices += paths[i].nstroke;
+}
+
+static void host_render_triangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation,
+    NVGscissor* scissor, const NVGvertex* verts, int nverts, float fringe)
+{
+    nvg::DkRenderer* renderer = ((host_backend*)uptr)->renderer;
+
+    renderer->triangles++;
+    renderer->vertices += nverts;
+}
+
+static void host_render_delete(void* uptr)
+{
+    delete (host_backend*)uptr;
+}
+
+NVGcontext* nvgCreateDk(nvg::DkRenderer* renderer, int flags)
+{
+    NVGparams params = {};
+    host_backend* backend = new host_backend();
+
+    backend->renderer = renderer;
+
+    params.userPtr              = backend;
+    params.edgeAntiAlias        = flags & NVG_ANTIALIAS ? 1 : 0;
+    params.renderCreate         = host_render_create;
+    params.renderCreateTexture  = host_render_create_texture;
+    params.renderDeleteTexture  = host_render_delete_texture;
+    params.renderUpdateTexture  = host_render_update_texture;
+    params.renderGetTextureSize = host_render_get_texture_size;
+    params.renderViewport       = host_render_viewport;
+    params.renderCancel         = host_render_cancel;
+    params.renderFlush          = host_render_flush;
+    params.renderFill           = host_render_fill;
+    params.renderStroke         = host_render_stroke;
+    params.renderTriangles      = host_render_triangles;
+    params.renderDelete         = host_render_delete;
+
+    return nvgCreateInternal(&params);
+}
+
+void nvgDeleteDk(NVGcontext* ctx)
+{
+    nvgDeleteInternal(ctx);
+}
@@ -0,0 +1,51 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Host stand-in for the deko3d NanoVG backend: contexts are real NanoVG
+ * contexts (paths are flattened and tessellated as on the device) whose
+ * render callbacks only count what would have been submitted. */
+#if !defined(HOST_NANOVG_DK_H)
+#define HOST_NANOVG_DK_H
+#include <switch.h>
+#include <nanovg.h>
+
+enum NVGcreateFlags
+{
+    NVG_ANTIALIAS       = 1 << 0,
+    NVG_STENCIL_STROKES = 1 << 1,
+    NVG_DEBUG           = 1 << 2,
+};
+
+namespace nvg
+{
+    class DkRenderer
+    {
+    public:
+        /* What the frame would have sent to the GPU */
+        u64 fills = 0;
+        u64 strokes = 0;
+        u64 triangles = 0;
+        u64 vertices = 0;
+        u64 flushes = 0;
+    };
+} // namespace nvg
+
+NVGcontext* nvgCreateDk(nvg::DkRenderer* renderer, int flags);
+void nvgDeleteDk(NVGcontext* ctx);
+
+#endif /* HOST_NANOVG_DK_H */
@@ -0,0 +1,109 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Host stand-in for the parts of libnx DkUIState uses. Input always
+ * reads as idle (replays bypass the pad), shared fonts are loaded from
+ * EXUI_HOST_FONT and the system tick is CLOCK_MONOTONIC at 19.2 MHz. */
+#if !defined(HOST_SWITCH_H)
+#define HOST_SWITCH_H
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u32 Result;
+
+#define R_FAILED(res)    ((res) != 0)
+#define R_SUCCEEDED(res) ((res) == 0)
+
+void diagAbortWithResult(Result res);
+
+u64 armGetSystemTick(void);
+
+static inline u64 armTicksToNs(u64 tick)
+{
+    return (tick * 625) / 12;
+}
+
+static inline u64 armNsToTicks(u64 ns)
+{
+    return (ns * 12) / 625;
+}
+
+typedef enum
+{
+    PlServiceType_User = 0,
+} PlServiceType;
+
+typedef enum
+{
+    PlSharedFontType_Standard = 0,
+    PlSharedFontType_ChineseSimplified = 1,
+    PlSharedFontType_ExtChineseSimplified = 2,
+    PlSharedFontType_ChineseTraditional = 3,
+    PlSharedFontType_KO = 4,
+    PlSharedFontType_NintendoExt = 5,
+} PlSharedFontType;
+
+typedef struct
+{
+    u32 type;
+    u32 offset;
+    u32 size;
+    void* address;
+} PlFontData;
+
+Result plInitialize(PlServiceType service_type);
+void plExit(void);
+Result plGetSharedFontByType(PlFontData* font, PlSharedFontType SharedFontType);
+
+#define HidNpadStyleSet_NpadStandard 0x1F
+
+typedef struct
+{
+    u64 buttons_cur;
+    u64 buttons_old;
+} PadState;
+
+#define KEY_A     (1ull << 0)
+#define KEY_B     (1ull << 1)
+#define KEY_X     (1ull << 2)
+#define KEY_Y     (1ull << 3)
+#define KEY_PLUS  (1ull << 10)
+#define KEY_MINUS (1ull << 11)
+
+static inline void padConfigureInput(u32 max_players, u32 style_set) { (void)max_players; (void)style_set; }
+static inline void padInitializeDefault(PadState* pad) { pad->buttons_cur = pad->buttons_old = 0; }
+static inline void padUpdate(PadState* pad) { pad->buttons_old = pad->buttons_cur; }
+static inline u64 padGetButtons(const PadState* pad) { return pad->buttons_cur; }
+static inline u64 padGetButtonsDown(const PadState* pad) { return pad->buttons_cur & ~pad->buttons_old; }
+static inline u64 padGetButtonsUp(const PadState* pad) { return pad->buttons_old & ~pad->buttons_cur; }
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* HOST_SWITCH_H */
@@ -0,0 +1,131 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Replays an input log recorded through DkUIState::setInputRecorder
+ * against a null NanoVG backend. Time comes from the log, so every run
+ * steps the UI through the same states; the printed digest of that
+ * sequence must match between runs and builds. CPU cost is measured
+ * per frame around onFrame() and render(). */
+
+#include "eXUI/ui_state.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace eXUI;
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* FNV-1a */
+static void digest_add(uint64_t& digest, uint64_t value)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        digest ^= (value >> (i * 8)) & 0xFF;
+        digest *= 0x100000001b3ull;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    nvg::DkRenderer renderer;
+    InputReplayer replayer;
+    std::vector<uint64_t> costs;
+    uint64_t digest   = 0xcbf29ce484222325ull;
+    uint64_t rendered = 0;
+    uint64_t total    = 0;
+    double redrawn    = 0.0;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <input log>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!replayer.open(argv[1]))
+    {
+        fprintf(stderr, "%s: not an input log\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    {
+        DkUIState ui(&renderer);
+
+        ui.setInputReplayer(&replayer);
+
+        for (;;)
+        {
+            uint64_t start = now_ns();
+            bool dirty;
+
+            if (!ui.onFrame(0))
+                break;
+
+            dirty = ui.isDirty();
+            if (dirty)
+            {
+                /* Alternates two back buffers like the swapchain does */
+                const DamageRegion& damage = ui.beginFrame(rendered % 2);
+
+                for (int i = 0; i < damage.count; i++)
+                    redrawn += (double)damage.rects[i].w * damage.rects[i].h / (1280 * 720);
+
+                ui.render(ui.getFrameTime(), 1280, 720);
+                rendered++;
+            }
+
+            costs.push_back(now_ns() - start);
+
+            digest_add(digest, ui.getFrameTime());
+            digest_add(digest, dirty);
+            digest_add(digest, ui.getAnimations()->isActive());
+        }
+    }
+
+    if (costs.empty())
+    {
+        fprintf(stderr, "%s: no frames\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    for (uint64_t cost : costs)
+        total += cost;
+    std::sort(costs.begin(), costs.end());
+
+    printf("frames      %zu (%llu rendered)\n", costs.size(), (unsigned long long)rendered);
+    printf("cpu/frame   avg %.1f us  p50 %.1f us  p99 %.1f us  max %.1f us\n",
+        total / 1000.0 / costs.size(),
+        costs[costs.size() / 2] / 1000.0,
+        costs[costs.size() * 99 / 100] / 1000.0,
+        costs.back() / 1000.0);
+    printf("redrawn     %.1f%% of the screen per rendered frame\n", rendered ? 100.0 * redrawn / rendered : 0.0);
+    printf("submitted   %llu fills  %llu strokes  %llu text batches  %llu vertices\n",
+        (unsigned long long)renderer.fills, (unsigned long long)renderer.strokes,
+        (unsigned long long)renderer.triangles, (unsigned long long)renderer.vertices);
+    printf("digest      %016llx\n", (unsigned long long)digest);
+
+    return EXIT_SUCCESS;
+}
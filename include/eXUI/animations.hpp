@@ -22,6 +22,11 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "eXUI/timer_wheel.hpp"
 
 namespace eXUI
 {
@@ -80,6 +85,9 @@ namespace eXUI
         EASING_OUT_BOUNCE,
         EASING_IN_OUT_BOUNCE,
         EASING_OUT_IN_BOUNCE,
+        /* Critically damped spring, settles in about `duration` ms
+         * and keeps its velocity when retargeted */
+        EASING_SPRING,
 
         EASING_LAST
     };
@@ -96,6 +104,13 @@ namespace eXUI
 
     typedef uintptr_t menu_animation_ctx_tag;
 
+    /* Slot-map handle to a pushed tween: slot index in the low
+     * 32 bits, slot generation in the high 32 bits. A handle goes
+     * stale as soon as its tween finishes or is killed. */
+    typedef uint64_t menu_animation_handle_t;
+
+    #define MENU_ANIMATION_INVALID_HANDLE ((menu_animation_handle_t)0)
+
     typedef struct menu_animation_ctx_subject
     {
         size_t count;
@@ -141,6 +156,187 @@ namespace eXUI
         menu_animation_ctx_entry_t entry;
     } menu_delayed_animation_t;
 
+    /* Monotonic clock in microseconds, see cpu_features_get_time_usec() */
+    typedef std::function<int64_t(void)> animation_clock_cb;
+
+    /* Per-frame tween state, packed together so the update
+     * loop only walks the data it actually needs */
+    struct tween_hot
+    {
+        float running_since;
+        float duration;
+        float initial_value;
+        float target_value;
+        float* subject;
+        float velocity; /* EASING_SPRING only, units per ms */
+        uint8_t easing; /* menu_animation_easing_type */
+    };
+
+    /* Tween state only touched on tick, completion or kill */
+    struct tween_cold
+    {
+        uintptr_t tag;
+        uint32_t slot;
+        tween_cb cb;
+        tween_cb tick;
+        void* userdata;
+    };
+
+    struct tween_slot
+    {
+        uint32_t index; /* into the hot/cold arrays while alive */
+        uint32_t generation;
+    };
+
+    /* Up to three spans (text, spacer, text) that together make up
+     * the visible part of a ticker, meant to be drawn back to back */
+    typedef struct menu_animation_ticker_spans
+    {
+        size_t count;
+        std::string_view spans[3];
+    } menu_animation_ticker_spans_t;
+
+    /* Retained ticker for one label. The codepoint-to-byte offset index
+     * of the text and spacer is built once in setText(), after which
+     * update() only slices the stored strings: no copies, no rescans.
+     * Spans stay valid until the next setText(). */
+    class Ticker
+    {
+    public:
+        Ticker();
+        /* The cached spans point into the source's strings, so a
+         * copied or moved ticker rebuilds them on its next update() */
+        Ticker(const Ticker& other);
+        Ticker(Ticker&& other) noexcept;
+        Ticker& operator=(const Ticker& other);
+        Ticker& operator=(Ticker&& other) noexcept;
+
+        void setText(std::string_view str, std::string_view spacer = std::string_view());
+        bool update(uint64_t idx, size_t len, bool selected, enum menu_animation_ticker_type type);
+        const menu_animation_ticker_spans_t& getSpans();
+
+    private:
+        std::string m_text;
+        std::string m_spacer;
+        /* byte offset of every codepoint, plus the end of the string */
+        std::vector<uint32_t> m_textOffsets;
+        std::vector<uint32_t> m_spacerOffsets;
+
+        menu_animation_ticker_spans_t m_spans;
+        bool m_valid;
+        uint64_t m_idx;
+        size_t m_len;
+        bool m_selected;
+        enum menu_animation_ticker_type m_type;
+        bool m_scrolling;
+
+        std::string_view textSlice(size_t offset, size_t width);
+        std::string_view spacerSlice(size_t offset, size_t width);
+    };
+
+    /* What a timer wheel node fires: either a menu timer or a
+     * delayed tween that gets pushed into the tween store */
+    struct menu_timer_payload
+    {
+        menu_timer_t* timer;
+        tween_cb cb;
+        void* userdata;
+        bool delayed;
+        menu_animation_ctx_entry_t entry;
+    };
+
+    /* Owns a tween store, its timers and the ticker/highlight clocks.
+     * Engines are independent of each other; a single engine is not
+     * thread safe and must only be used from one thread at a time. */
+    class AnimationEngine
+    {
+    public:
+        AnimationEngine(animation_clock_cb clock = nullptr);
+        ~AnimationEngine();
+
+        void clear();
+        bool update();
+        menu_animation_handle_t push(menu_animation_ctx_entry_t* entry);
+        void pushDelayed(unsigned delay, menu_animation_ctx_entry_t* entry);
+        bool kill(menu_animation_handle_t handle);
+        bool retarget(menu_animation_handle_t handle, float target_value, float duration);
+        bool getProgress(menu_animation_handle_t handle, float* progress);
+        bool isAlive(menu_animation_handle_t handle);
+        bool killByTag(menu_animation_ctx_tag* tag);
+        void killBySubject(menu_animation_ctx_subject_t* subject);
+        void timerStart(menu_timer_t* timer, menu_timer_ctx_entry_t* timer_entry);
+        void timerKill(menu_timer_t* timer);
+        bool ticker(menu_animation_ctx_ticker_t* ticker);
+        bool ticker(Ticker* ticker, size_t len, bool selected, enum menu_animation_ticker_type type);
+        bool ctl(enum menu_animation_ctl_state state, void* data);
+        bool isActive();
+        float getDeltaTime();
+        uint64_t getTickerIdx();
+        uint64_t getTickerSlowIdx();
+        void getHighlight(float* gradient_x, float* gradient_y, float* color);
+
+        /* Engine used by the menu_animation_* functions */
+        static AnimationEngine* getDefault();
+        static void setDefault(AnimationEngine* engine);
+
+    private:
+        animation_clock_cb m_clock;
+
+        /* Tweens are stored as parallel hot/cold arrays: index i of
+         * both vectors (and of m_deleted) describes the same tween.
+         * Removal swaps the last tween into the freed index, so the
+         * store order is not the push order. Handles go through
+         * m_slots, which follows tweens as they move. */
+        std::vector<tween_hot> m_hot;
+        std::vector<tween_cold> m_cold;
+        std::vector<uint8_t> m_deleted;
+        std::vector<tween_slot> m_slots;
+        std::vector<uint32_t> m_freeSlots;
+        /* Secondary indexes, tag and subject to slot */
+        std::unordered_multimap<uintptr_t, uint32_t> m_tagIndex;
+        std::unordered_multimap<float*, uint32_t> m_subjectIndex;
+        /* update() scratch: live tween indices grouped by easing type */
+        std::vector<uint32_t> m_order;
+
+        /* Timers without a tick callback and delayed tweens */
+        TimerWheel<menu_timer_payload> m_timers;
+        std::unordered_map<menu_timer_t*, timer_wheel_handle_t> m_timerHandles;
+        std::vector<uint32_t> m_expiredTimers;
+        bool m_pendingDeletes;
+        bool m_inUpdate;
+        /* Bumped by clear(), so update() notices a callback emptying
+         * the store under it */
+        uint32_t m_clears;
+
+        int64_t m_curTime;
+        int64_t m_oldTime;
+        int64_t m_lastClockUpdate;
+        int64_t m_lastTickerUpdate;
+        int64_t m_lastTickerSlowUpdate;
+        uint64_t m_tickerIdx;     /* updated every TICKER_SPEED ms */
+        uint64_t m_tickerSlowIdx; /* updated every TICKER_SLOW_SPEED ms */
+        float m_deltaTime;
+        bool m_animationIsActive;
+        bool m_tickerIsActive;
+
+        double m_highlightGradientX;
+        double m_highlightGradientY;
+        double m_highlightColor;
+
+        void updateTime(bool timedate_enable);
+        int64_t timerNow();
+        void fireTimers();
+        void easeGroup(uint8_t type, const uint32_t* indices, size_t count);
+        void springGroup(const uint32_t* indices, size_t count);
+        int64_t find(menu_animation_handle_t handle);
+        void removeAt(size_t i);
+        void killAt(size_t i);
+    };
+
+    /* Scalar reference easing function, NULL for EASING_SPRING */
+    easing_cb menu_animation_get_easing(enum menu_animation_easing_type type);
+
+    /* Compatibility wrappers over AnimationEngine::getDefault() */
     void menu_timer_start(menu_timer_t* timer, menu_timer_ctx_entry_t* timer_entry);
     void menu_timer_kill(menu_timer_t* timer);
     void menu_animation_init(void);
@@ -151,7 +347,10 @@ namespace eXUI
     bool menu_animation_is_active(void);
     bool menu_animation_kill_by_tag(menu_animation_ctx_tag* tag);
     void menu_animation_kill_by_subject(menu_animation_ctx_subject_t* subject);
-    bool menu_animation_push(menu_animation_ctx_entry_t* entry);
+    menu_animation_handle_t menu_animation_push(menu_animation_ctx_entry_t* entry);
+    bool menu_animation_kill(menu_animation_handle_t handle);
+    bool menu_animation_retarget(menu_animation_handle_t handle, float target_value, float duration);
+    bool menu_animation_get_progress(menu_animation_handle_t handle, float* progress);
     void menu_animation_push_delayed(unsigned delay, menu_animation_ctx_entry_t* entry);
     bool menu_animation_ctl(enum menu_animation_ctl_state state, void* data);
     uint64_t menu_animation_get_ticker_idx(void);
@@ -2,51 +2,125 @@
 #define APPLICATION_HPP
 #include <nanovg/framework/CApplication.h>
 #include <nanovg/framework/CMemPool.h>
+#include "eXUI/frame_pacer.hpp"
+#include "eXUI/gpu_pool.hpp"
+#include "eXUI/log_sink.hpp"
+#include "eXUI/resolution_governor.hpp"
 #include "eXUI/ui_state.hpp"
 
 namespace eXUI
 {
-	static constexpr unsigned NumFramebuffers = 2;
+	static constexpr unsigned MaxFramebuffers = 3;
 	static constexpr unsigned StaticCmdSize = 0x1000;
+	static constexpr unsigned FrameCmdSize = 0x1000; // per back buffer
+	static constexpr u64 IdleFrameInterval = 16666667; // ns, one 60 Hz vsync
+
+	enum class PresentMode
+	{
+		// Double buffered, and the CPU waits for the GPU after each present,
+		// so input is sampled as close to scan-out as possible
+		LOW_LATENCY,
+		// Triple buffered, the CPU records the next frame while the GPU
+		// still draws the last one; costs up to a frame of latency
+		THROUGHPUT,
+	};
+
+	// Initial GPU memory budgets. Each pool starts with one block of its
+	// size and adds more blocks when an allocation does not fit.
+	struct DkApplicationConfig
+	{
+		// Renderer textures, fonts and images
+		uint32_t imagePoolSize = 16*1024*1024;
+		uint32_t codePoolSize = 128*1024;
+		// Command memory, vertex and uniform data
+		uint32_t dataPoolSize = 1*1024*1024;
+		// Depth buffer and swapchain images; 0 sizes it for the current
+		// output and swapchain depth
+		uint32_t framebufferPoolSize = 0;
+		// The framebuffer pool is rebuilt after this many idle frames if
+		// it has grown, is larger than needed or more fragmented than this
+		float compactFragmentation = 0.25f;
+		unsigned compactIdleFrames = 120;
+	};
 
 	class DkApplication : public CApplication
 	{
 	public:
-		DkApplication();
+		DkApplication(const DkApplicationConfig& config = DkApplicationConfig());
 		~DkApplication();
 
 	private:
-		const uint32_t FramebufferWidth = 1280;
-		const uint32_t FramebufferHeight = 720;
-		uint32_t OutputWidth;
-		uint32_t OutputHeight;
+		// The UI is laid out in these units and scaled to the framebuffer
+		const uint32_t UIWidth = 1280;
+		const uint32_t UIHeight = 720;
+		// Follows the output: 1080p docked, 720p handheld
+		uint32_t FramebufferWidth = 1280;
+		uint32_t FramebufferHeight = 720;
+		uint32_t OutputWidth = 1280;
+		uint32_t OutputHeight = 720;
+		// Part of the framebuffer drawn into, set by the governor
+		uint32_t RenderWidth = 1280;
+		uint32_t RenderHeight = 720;
 
 		dk::UniqueDevice m_device;
 		dk::UniqueQueue m_queue;
 		dk::UniqueSwapchain m_swapchain;
 
+		DkApplicationConfig m_config;
 		std::optional<CMemPool> m_pool_images;
 		std::optional<CMemPool> m_pool_code;
-		std::optional<CMemPool> m_pool_data;
+		GpuPool m_pool_data;
+		GpuPool m_pool_framebuffers;
+		uint32_t m_framebufferBytes;
+		unsigned m_idleFrames;
 
 		dk::UniqueCmdBuf m_cmdbuf;
 		DkCmdList m_render_cmdlist;
+		dk::UniqueCmdBuf m_frame_cmdbuf;
+		CMemPool::Handle m_frame_cmdmem;
+		dk::Fence m_frame_fences[MaxFramebuffers];
+		CMemPool::Handle m_cmdbuf_mem;
 
 		dk::Image m_depthBuffer;
 		CMemPool::Handle m_depthBuffer_mem;
-		dk::Image m_framebuffers[NumFramebuffers];
-		CMemPool::Handle m_framebuffers_mem[NumFramebuffers];
-		DkCmdList m_framebuffer_cmdlists[NumFramebuffers];
+		unsigned m_numFramebuffers;
+		unsigned m_pendingFramebuffers;
+		uint32_t m_swapInterval;
+		bool m_waitIdle;
+		bool m_swapchainChanged;
+		dk::Image m_framebuffers[MaxFramebuffers];
+		CMemPool::Handle m_framebuffers_mem[MaxFramebuffers];
+		DkCmdList m_framebuffer_cmdlists[MaxFramebuffers];
 
 		std::optional<nvg::DkRenderer> m_renderer;
 		std::optional<DkUIState> m_uiState;
+		FramePacer m_pacer;
+		ResolutionGovernor m_governor;
+#if defined(DEBUG_NXLINK)
+		std::optional<SocketLogSink> m_nxlinkSink;
+#endif /* DEBUG_NXLINK */
 
 		void createFramebufferResources();
 		void recordStaticCommands();
+		void submitClear(int slot, const DamageRegion& damage);
 		void destroyFramebufferResources();
 		void onFramebufferDimensionChange();
+		void setRenderSize(uint32_t width, uint32_t height);
+		bool compactFramebufferPool();
 		void render(u64 ns);
 
+	public:
+		FramePacer* getFramePacer();
+		ResolutionGovernor* getResolutionGovernor();
+		GpuPoolStats getFramebufferPoolStats();
+
+		// Take effect at the start of the next frame, rebuilding the
+		// swapchain if the depth changed
+		void setPresentMode(PresentMode mode);
+		void setSwapchain(unsigned depth, uint32_t swapInterval, bool waitIdle);
+		unsigned getSwapchainDepth();
+		uint32_t getSwapInterval();
+
 	protected:
 		bool onFrame(u64 ns) override;
 		void onOperationMode(AppletOperationMode opMode) override;
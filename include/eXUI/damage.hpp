@@ -0,0 +1,84 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#if !defined(DAMAGE_HPP)
+#define DAMAGE_HPP
+#include <stdint.h>
+
+namespace eXUI
+{
+    constexpr int DAMAGE_MAX_RECTS = 8;   // more get merged together
+    constexpr unsigned DAMAGE_HISTORY = 4; // frames of history, >= swapchain depth
+    constexpr float DAMAGE_FULL_RATIO = 0.6f; // of the screen, above which a full redraw is cheaper
+
+    struct DamageRect
+    {
+        int x, y, w, h;
+    };
+
+    /* Disjoint rectangles, in pixels. `full` is set when the region
+     * covers the whole screen, in which case rects holds that one rect. */
+    struct DamageRegion
+    {
+        bool full;
+        int count;
+        DamageRect rects[DAMAGE_MAX_RECTS];
+    };
+
+    /* Collects the areas that changed since the last frame and works out
+     * which of them a back buffer has to redraw. Swapchain images keep
+     * their contents, so a buffer last drawn k frames ago is brought up to
+     * date by redrawing the damage of those k frames; one that was never
+     * drawn, or is older than the history, is redrawn in full. */
+    class DamageTracker
+    {
+    public:
+        DamageTracker(int width, int height);
+
+        // Forgets every buffer's contents, e.g. after they were recreated
+        void reset(int width, int height);
+
+        void add(float x, float y, float w, float h);
+        void addFull();
+        // Damage that is redrawn but not reported in getFrameDamage(),
+        // such as erasing the debug flash of the previous frame
+        void addOverdraw(float x, float y, float w, float h);
+        bool isEmpty();
+
+        // Closes the frame and returns what back buffer `slot` needs to
+        // redraw before it is presented
+        const DamageRegion& resolve(unsigned slot);
+        // Damage reported for the frame closed by the last resolve()
+        const DamageRegion& getFrameDamage();
+
+    private:
+        int m_width, m_height;
+        DamageRegion m_current;
+        DamageRegion m_overdraw;
+        DamageRegion m_reported;
+        DamageRegion m_history[DAMAGE_HISTORY];
+        uint64_t m_frame;
+        uint64_t m_slotFrame[DAMAGE_HISTORY]; // frame each buffer was last drawn in, 0 never
+        DamageRegion m_region;
+
+        void clip(DamageRect& rect, float x, float y, float w, float h);
+        void merge(DamageRegion& region, DamageRect rect);
+        void setFull(DamageRegion& region);
+    };
+} // namespace eXUI
+#endif /* DAMAGE_HPP */
@@ -0,0 +1,72 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#if !defined(FRAME_PACER_HPP)
+#define FRAME_PACER_HPP
+#include <switch.h>
+#include "eXUI/perf.hpp"
+
+namespace eXUI
+{
+    /* Jitter histogram: distance of each frame interval from the
+     * nearest vsync boundary, in 0.25 ms buckets, the last one
+     * collecting everything further out */
+    constexpr int FRAME_PACER_JITTER_BUCKETS = 32;
+    constexpr u64 FRAME_PACER_JITTER_STEP = 250000; // ns
+
+    struct FramePacingStats
+    {
+        u64 frames;         // intervals measured
+        u64 missedFrames;   // frames that took more than one vsync
+        u64 missedVsyncs;   // vsyncs those frames overran by
+        u64 bursts;         // runs of two or more missed frames
+        u32 streak;         // current run of missed frames
+        u32 longestStreak;
+        u64 lastInterval;   // ns between the last two acquires
+        u64 lastLatency;    // ns from the last acquire to its present
+        u32 jitter[FRAME_PACER_JITTER_BUCKETS];
+    };
+
+    /* Frame pacing monitor: DkApplication stamps every acquireImage and
+     * presentImage. The acquire to acquire interval is the on-screen
+     * duration of a frame, since acquiring blocks on the swapchain.
+     * Frames skipped by on-demand rendering break the chain through
+     * idle() so the gap is not reported as a stutter. */
+    class FramePacer
+    {
+    public:
+        FramePacer(u64 vsyncPeriod = 16666667);
+
+        void acquired(u64 ns);
+        void presented(u64 ns);
+        void idle();
+        void reset();
+        // Frame period to measure against, e.g. two vsyncs at a swap
+        // interval of 2; resets the stats
+        void setVsyncPeriod(u64 vsyncPeriod);
+
+        const FramePacingStats& getStats();
+        PerfGraph* getGraph();
+
+    private:
+        u64 m_vsyncPeriod;
+        u64 m_lastAcquire;
+        FramePacingStats m_stats;
+        PerfGraph m_graph;
+    };
+} // namespace eXUI
+#endif /* FRAME_PACER_HPP */
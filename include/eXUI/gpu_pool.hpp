@@ -0,0 +1,87 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#if !defined(GPU_POOL_HPP)
+#define GPU_POOL_HPP
+#include <nanovg/framework/CMemPool.h>
+#include <optional>
+#include <vector>
+
+namespace eXUI
+{
+    struct GpuPoolStats
+    {
+        uint32_t blocks;      /* memory blocks the pool has created */
+        uint32_t growths;     /* blocks added beyond the first */
+        uint64_t reserved;    /* bytes in those blocks */
+        uint64_t used;        /* bytes in live allocations */
+        uint64_t largestFree; /* largest gap between them */
+        float fragmentation;  /* 1 - largestFree / free, 0 when free is one gap */
+    };
+
+    /* CMemPool with bookkeeping: CMemPool already grows by adding blocks
+     * of its block size when an allocation does not fit, but does not
+     * say so. Allocations made through GpuPool are recorded, so the pool
+     * can report its blocks and how fragmented the space between those
+     * allocations is, and be rebuilt with a different block size once
+     * they are all released. Allocations made directly on get(), such
+     * as the renderer's, are not seen. */
+    class GpuPool
+    {
+    public:
+        GpuPool(const char* name);
+
+        void create(DkDevice device, uint32_t flags, uint32_t blockSize);
+        bool isCreated();
+        CMemPool& get();
+
+        CMemPool::Handle allocate(uint32_t size, uint32_t alignment = DK_CMDMEM_ALIGNMENT);
+        void free(CMemPool::Handle& handle);
+
+        /* Releases every block and starts over with `blockSize`; only
+         * possible with no allocations live, returns false otherwise */
+        bool compact(uint32_t blockSize);
+
+        GpuPoolStats getStats();
+        uint32_t getBlockSize();
+
+    private:
+        struct Extent
+        {
+            DkMemBlock block;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        struct Block
+        {
+            DkMemBlock block;
+            uint32_t size;
+        };
+
+        const char* m_name;
+        DkDevice m_device;
+        uint32_t m_flags;
+        uint32_t m_blockSize;
+        int m_telemetry;
+        std::optional<CMemPool> m_pool;
+        std::vector<Block> m_blocks;
+        std::vector<Extent> m_extents;
+    };
+} // namespace eXUI
+#endif /* GPU_POOL_HPP */
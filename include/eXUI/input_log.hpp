@@ -0,0 +1,95 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#if !defined(INPUT_LOG_HPP)
+#define INPUT_LOG_HPP
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+namespace eXUI
+{
+    /* Everything DkUIState::onFrame reads from the outside world */
+    struct InputFrame
+    {
+        uint64_t ns;   /* frame timestamp, also the animation clock */
+        uint64_t down; /* padGetButtonsDown */
+        uint64_t held; /* padGetButtons */
+        uint64_t up;   /* padGetButtonsUp */
+    };
+
+    /* Input logs start with "EXIR" and a version byte, followed by one
+     * record per frame:
+     *   u8 flags, varint ns delta from the previous frame,
+     *   varint held       if flags & INPUT_LOG_HELD,
+     *   varint down       if flags & INPUT_LOG_DOWN,
+     *   varint up         if flags & INPUT_LOG_UP.
+     * Down and up are only stored when they differ from the edges
+     * derived from consecutive held states, so an idle frame takes
+     * one flag byte plus the timestamp (five bytes at 60 Hz). */
+    enum
+    {
+        INPUT_LOG_HELD = 1 << 0,
+        INPUT_LOG_DOWN = 1 << 1,
+        INPUT_LOG_UP   = 1 << 2,
+    };
+
+    constexpr uint8_t INPUT_LOG_VERSION = 1;
+
+    class InputRecorder
+    {
+    public:
+        InputRecorder();
+        ~InputRecorder();
+
+        bool open(const char* path);
+        void close();
+        bool isOpen();
+        void record(const InputFrame& frame);
+
+    private:
+        FILE* m_file;
+        std::vector<uint8_t> m_buffer;
+        uint64_t m_lastNs;
+        uint64_t m_lastHeld;
+
+        void flush();
+    };
+
+    class InputReplayer
+    {
+    public:
+        InputReplayer();
+
+        bool open(const char* path);
+        bool isOpen();
+
+        /* Next recorded frame, false once the log is exhausted */
+        bool next(InputFrame& frame);
+        uint32_t getFrame();
+
+    private:
+        std::vector<uint8_t> m_data;
+        size_t m_pos;
+        uint32_t m_frame;
+        uint64_t m_lastNs;
+        uint64_t m_lastHeld;
+
+        bool readVarint(uint64_t& value);
+    };
+} // namespace eXUI
+#endif /* INPUT_LOG_HPP */
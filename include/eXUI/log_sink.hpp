@@ -0,0 +1,109 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#if !defined(LOG_SINK_HPP)
+#define LOG_SINK_HPP
+#include <stdio.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eXUI
+{
+    /* Destination of Logger output. The async writer hands sinks whole
+     * batches of lines (always ending on a line boundary); without the
+     * async backend every line is its own batch. Calls come from one
+     * thread at a time. */
+    class LogSink
+    {
+    public:
+        virtual ~LogSink() = default;
+
+        virtual void write(const char* data, size_t length) = 0;
+        // Pushes out anything the sink still buffers
+        virtual void flush() {}
+    };
+
+    /* Buffered file output. Once the file reaches `maxSize` bytes it is
+     * renamed to `path`.1 (shifting older ones up to `path`.`keep`) and
+     * a new file is started. */
+    class FileLogSink : public LogSink
+    {
+    public:
+        FileLogSink(const std::string& path, size_t maxSize = 1024 * 1024, unsigned keep = 2, size_t bufferSize = 0x10000);
+        ~FileLogSink();
+
+        bool isOpen();
+        void write(const char* data, size_t length) override;
+        void flush() override;
+
+    private:
+        std::string m_path;
+        size_t m_maxSize;
+        unsigned m_keep;
+        FILE* m_file;
+        size_t m_size;
+        std::vector<char> m_buffer;
+        size_t m_used;
+
+        void open();
+        void rotate();
+        void append(const char* data, size_t length);
+    };
+
+    /* Sends to a connected stream socket, such as the one from
+     * nxlinkConnectToHost(), in batches of `batchSize` bytes. Size it
+     * after the socket's TCP send buffer so a batch is one send. Stops
+     * sending (and counts dropped bytes) after a socket error. */
+    class SocketLogSink : public LogSink
+    {
+    public:
+        SocketLogSink(int socket, size_t batchSize);
+
+        void write(const char* data, size_t length) override;
+        void flush() override;
+        size_t getDroppedBytes();
+
+    private:
+        int m_socket;
+        std::vector<char> m_buffer;
+        size_t m_used;
+        size_t m_dropped;
+    };
+
+    /* Keeps the last `capacity` lines in memory, e.g. to show recent log
+     * output in an error screen. Safe to query from any thread. */
+    class RingLogSink : public LogSink
+    {
+    public:
+        RingLogSink(size_t capacity = 64);
+
+        void write(const char* data, size_t length) override;
+
+        // Oldest first, at most `count` lines, without their newlines
+        std::vector<std::string> getLastLines(size_t count);
+
+    private:
+        std::mutex m_mutex;
+        std::vector<std::string> m_lines;
+        size_t m_next;
+        size_t m_count;
+        std::string m_partial;
+    };
+} // namespace eXUI
+#endif /* LOG_SINK_HPP */
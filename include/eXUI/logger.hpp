@@ -19,10 +19,26 @@
 #if !defined(LOGGER_HPP)
 #define LOGGER_HPP
 #include <fmt/core.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string.h>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include "eXUI/trace.hpp"
+
+// Calls below this level compile to nothing when made through the
+// EXUI_LOG_* / EXUI_DLOG_* macros (0 = errors only, 3 = debug)
+#if !defined(EXUI_LOG_MIN_LEVEL)
+#define EXUI_LOG_MIN_LEVEL 3
+#endif
 
 namespace eXUI
 {
+    class LogSink;
+
     enum class LogLevel
     {
         ERROR = 0,
@@ -31,57 +47,265 @@ namespace eXUI
         DEBUG
     };
 
+    // What producers do when the async ring is full
+    enum class LogOverflow
+    {
+        DROP,  // discard the line, the writer reports how many were lost
+        BLOCK, // wait for the writer to free a record
+    };
+
+    constexpr size_t LOG_RECORD_SIZE = 256; // longer lines are truncated
+    constexpr uint32_t LOG_RING_SIZE = 512; // power of two
+
+    enum class LogRecordKind : uint8_t
+    {
+        TEXT,     // formatted line
+        DEFERRED, // format string and encoded arguments, see LogArg
+    };
+
+    // Argument tags of deferred records; each tag byte is followed by
+    // the raw value, strings by a u16 length and their bytes
+    enum LogArg : uint8_t
+    {
+        LOG_ARG_I64 = 1,
+        LOG_ARG_U64,
+        LOG_ARG_F64,
+        LOG_ARG_BOOL,
+        LOG_ARG_CHAR,
+        LOG_ARG_STR,
+        LOG_ARG_PTR,
+    };
+
+    struct LogRecord
+    {
+        std::atomic<uint32_t> sequence;
+        uint32_t length;
+        LogRecordKind kind;
+        LogLevel level;
+        const char* format; // deferred only, a string literal
+        uint64_t timestamp; // deferred only, us
+        char text[LOG_RECORD_SIZE];
+    };
+
     class Logger
     {
     public:
         static void setLogLevel(LogLevel logLevel);
 
-        template <typename... Args>
-        inline static void log(LogLevel logLevel, std::string prefix, std::string color, std::string format, Args&&... args)
+        // Moves output to a background thread: lines are formatted
+        // straight into a lock-free ring of preallocated records and
+        // written out in batches. stopAsync() drains the ring first.
+        static void startAsync(LogOverflow overflow = LogOverflow::DROP);
+        static void stopAsync();
+
+        // Blocks until every line logged so far has been written
+        static void flush();
+
+        // Routes output to `sink` (not owned) instead of stdout; sinks
+        // must stay alive until removed
+        static void addSink(LogSink* sink);
+        static void removeSink(LogSink* sink);
+
+        // Makes the writer store deferred records in a binary log
+        // (see bench/log_decode) instead of formatting them
+        static bool openBinaryLog(const char* path);
+        static void closeBinaryLog();
+
+        // Formats encoded deferred arguments with `format`
+        static std::string formatDeferred(const char* format, const char* args, size_t length);
+
+        template <LogLevel level, typename S, typename... Args>
+        inline static void log(const S& format, Args&&... args)
         {
-            if (Logger::logLevel < logLevel)
+            if ((int)level > EXUI_LOG_MIN_LEVEL || Logger::logLevel < level)
+                return;
+
+            LogRecord* record = Logger::acquire();
+            char local[LOG_RECORD_SIZE];
+            char* out = record ? record->text : local;
+            const size_t size = LOG_RECORD_SIZE - 1; // room for the newline
+            size_t header, length;
+
+            // ring full under LogOverflow::DROP
+            if (!record && Logger::async.load(std::memory_order_relaxed))
                 return;
 
+            header = Logger::writeHeader(level, out, size);
+
             try
             {
-                fmt::print("\033{}[{}]\033[0m ", color, prefix);
-                fmt::print(format, args...);
-                fmt::print("\n");
+                length = header + fmt::format_to_n(out + header, size - header, format, std::forward<Args>(args)...).size;
             }
             catch (const std::exception& e)
             {
-                // will be printed after the first fmt::print (so after the log tag)
-                printf("! Invalid log format string: \"%s\": %s\n", format.c_str(), e.what());
+                length = header + fmt::format_to_n(out + header, size - header, "! Invalid log format string: \"{}\": {}", fmt::string_view(format), e.what()).size;
             }
+
+            length = std::min(size, length);
+            out[length] = '\0';
+
+#if defined(EXUI_PROFILER)
+            if (Trace::isActive())
+                Trace::instant("log", out + header);
+#endif /* EXUI_PROFILER */
+
+            out[length++] = '\n';
+            if (record)
+                record->kind = LogRecordKind::TEXT;
+            Logger::commit(record, out, length);
         }
 
-        template <typename... Args>
-        inline static void error(std::string format, Args&&... args)
+        // Like log(), but only copies the raw arguments; formatting
+        // happens on the writer thread (or in the host decoder). The
+        // format must be a string literal. Formats immediately when
+        // the async backend is not running.
+        template <LogLevel level, typename S, typename... Args>
+        inline static void deferred(const S& format, const Args&... args)
         {
-            Logger::log(LogLevel::ERROR, "ERROR", "[0;31m", format, args...);
+            if ((int)level > EXUI_LOG_MIN_LEVEL || Logger::logLevel < level)
+                return;
+
+            if (!Logger::async.load(std::memory_order_relaxed))
+            {
+                Logger::log<level>(format, args...);
+                return;
+            }
+
+            LogRecord* record = Logger::acquire();
+            if (!record)
+                return;
+
+            char* out = record->text;
+            char* end = record->text + LOG_RECORD_SIZE;
+
+            (Logger::encode(out, end, args), ...);
+
+            record->kind = LogRecordKind::DEFERRED;
+            record->level = level;
+            record->format = fmt::string_view(format).data();
+            record->timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            Logger::commit(record, record->text, out - record->text);
+        }
+
+        template <typename S, typename... Args>
+        inline static void error(const S& format, Args&&... args)
+        {
+            Logger::log<LogLevel::ERROR>(format, std::forward<Args>(args)...);
         }
 
-        template <typename... Args>
-        inline static void warning(std::string format, Args&&... args)
+        template <typename S, typename... Args>
+        inline static void warning(const S& format, Args&&... args)
         {
-            Logger::log(LogLevel::WARNING, "WARNING", "[0;33m", format, args...);
+            Logger::log<LogLevel::WARNING>(format, std::forward<Args>(args)...);
         }
 
-        template <typename... Args>
-        inline static void info(std::string format, Args&&... args)
+        template <typename S, typename... Args>
+        inline static void info(const S& format, Args&&... args)
         {
-            Logger::log(LogLevel::INFO, "INFO", "[0;34m", format, args...);
+            Logger::log<LogLevel::INFO>(format, std::forward<Args>(args)...);
         }
 
-        template <typename... Args>
-        inline static void debug(std::string format, Args&&... args)
+        template <typename S, typename... Args>
+        inline static void debug(const S& format, Args&&... args)
         {
-            Logger::log(LogLevel::DEBUG, "DEBUG", "[0;32m", format, args...);
+            Logger::log<LogLevel::DEBUG>(format, std::forward<Args>(args)...);
         }
 
     private:
         inline static LogLevel logLevel = LogLevel::INFO;
+        inline static std::atomic<bool> async = false;
+
+        // Reserves a ring record; nullptr when not running async, or
+        // when the ring is full under LogOverflow::DROP
+        static LogRecord* acquire();
+        // Publishes the record, or writes `text` directly when not async
+        static void commit(LogRecord* record, const char* text, size_t length);
+        // Writes the colored level tag, returns its length
+        static size_t writeHeader(LogLevel level, char* out, size_t size);
+
+        template <typename T>
+        inline static void encodeRaw(char*& out, char* end, LogArg tag, T value)
+        {
+            if (end - out < (ptrdiff_t)(1 + sizeof(T)))
+            {
+                out = end; // truncated, the decoder stops here
+                return;
+            }
+
+            *out++ = (char)tag;
+            memcpy(out, &value, sizeof(T));
+            out += sizeof(T);
+        }
+
+        inline static void encode(char*& out, char* end, std::string_view value)
+        {
+            uint16_t length;
+
+            if (end - out < 3)
+            {
+                out = end;
+                return;
+            }
+
+            length = (uint16_t)std::min<size_t>(value.size(), end - out - 3);
+            *out++ = (char)LOG_ARG_STR;
+            memcpy(out, &length, sizeof(length));
+            memcpy(out + sizeof(length), value.data(), length);
+            out += sizeof(length) + length;
+        }
+
+        inline static void encode(char*& out, char* end, const char* value)
+        {
+            Logger::encode(out, end, std::string_view(value ? value : "(null)"));
+        }
+
+        inline static void encode(char*& out, char* end, const std::string& value)
+        {
+            Logger::encode(out, end, std::string_view(value));
+        }
+
+        template <typename T>
+        inline static void encode(char*& out, char* end, const T& value)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                Logger::encodeRaw(out, end, LOG_ARG_BOOL, value);
+            else if constexpr (std::is_same_v<T, char>)
+                Logger::encodeRaw(out, end, LOG_ARG_CHAR, value);
+            else if constexpr (std::is_enum_v<T>)
+                Logger::encodeRaw(out, end, LOG_ARG_I64, (int64_t)value);
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                Logger::encodeRaw(out, end, LOG_ARG_I64, (int64_t)value);
+            else if constexpr (std::is_integral_v<T>)
+                Logger::encodeRaw(out, end, LOG_ARG_U64, (uint64_t)value);
+            else if constexpr (std::is_floating_point_v<T>)
+                Logger::encodeRaw(out, end, LOG_ARG_F64, (double)value);
+            else if constexpr (std::is_pointer_v<T>)
+                Logger::encodeRaw(out, end, LOG_ARG_PTR, (uint64_t)(uintptr_t)value);
+            else
+                static_assert(!sizeof(T), "deferred log arguments must be numbers, strings or pointers");
+        }
     };
 
 } // namespace eXUI
+
+// Level-checked logging: format strings are checked at compile time and
+// calls below EXUI_LOG_MIN_LEVEL are removed along with their arguments
+#define EXUI_LOG_AT(level, call, format, ...) \
+    do { \
+        if constexpr ((int)(level) <= EXUI_LOG_MIN_LEVEL) \
+            ::eXUI::Logger::call<level>(FMT_STRING(format), ##__VA_ARGS__); \
+    } while (0)
+
+#define EXUI_LOG_ERROR(format, ...)    EXUI_LOG_AT(::eXUI::LogLevel::ERROR, log, format, ##__VA_ARGS__)
+#define EXUI_LOG_WARNING(format, ...)  EXUI_LOG_AT(::eXUI::LogLevel::WARNING, log, format, ##__VA_ARGS__)
+#define EXUI_LOG_INFO(format, ...)     EXUI_LOG_AT(::eXUI::LogLevel::INFO, log, format, ##__VA_ARGS__)
+#define EXUI_LOG_DEBUG(format, ...)    EXUI_LOG_AT(::eXUI::LogLevel::DEBUG, log, format, ##__VA_ARGS__)
+
+// Deferred variants, for hot paths
+#define EXUI_DLOG_ERROR(format, ...)   EXUI_LOG_AT(::eXUI::LogLevel::ERROR, deferred, format, ##__VA_ARGS__)
+#define EXUI_DLOG_WARNING(format, ...) EXUI_LOG_AT(::eXUI::LogLevel::WARNING, deferred, format, ##__VA_ARGS__)
+#define EXUI_DLOG_INFO(format, ...)    EXUI_LOG_AT(::eXUI::LogLevel::INFO, deferred, format, ##__VA_ARGS__)
+#define EXUI_DLOG_DEBUG(format, ...)   EXUI_LOG_AT(::eXUI::LogLevel::DEBUG, deferred, format, ##__VA_ARGS__)
+
 #endif /* LOGGER_HPP */
\ No newline at end of file
@@ -0,0 +1,83 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#if !defined(MEMORY_TELEMETRY_HPP)
+#define MEMORY_TELEMETRY_HPP
+#include <stdint.h>
+#include "eXUI/perf.hpp"
+
+namespace eXUI
+{
+    constexpr int MEMORY_MAX_POOLS = 8;
+    /* mallinfo() takes the malloc lock and walks every bin, so the
+     * heap is sampled once a second (at 60 Hz) rather than per frame */
+    constexpr int MEMORY_HEAP_SAMPLE_FRAMES = 60;
+
+    /* Usage of a GPU memory pool through the allocations reported to
+     * MemoryTelemetry; CMemPool keeps no statistics of its own, so
+     * allocations made directly by the renderer are not included */
+    struct MemoryPoolUsage
+    {
+        const char* name;
+        uint64_t blockSize; /* size the pool grows by */
+        uint64_t current;
+        uint64_t peak;
+        uint32_t live;        /* allocations currently held */
+        uint32_t allocations; /* allocations ever made */
+        uint32_t blocks;      /* pools reporting their layout, see GpuPool */
+        uint64_t reserved;
+        uint64_t largestFree;
+    };
+
+    struct MemoryFrameStats
+    {
+        uint64_t allocations; /* operator new calls during the frame */
+        uint64_t frees;
+        uint64_t bytes;       /* bytes requested through operator new */
+        uint64_t heapUsed;    /* malloc heap in use at the last heap sample */
+        uint64_t heapSize;
+    };
+
+    /* Memory telemetry: GPU pool usage as reported by the code that
+     * allocates from the pools, malloc heap usage, and, when built with
+     * EXUI_MEMORY_HOOKS, per-frame operator new/delete counts through
+     * replacement global operators. */
+    class MemoryTelemetry
+    {
+    public:
+        static int registerPool(const char* name, uint64_t blockSize);
+        static void poolAllocated(int pool, uint64_t size);
+        static void poolFreed(int pool, uint64_t size);
+        static void poolLayout(int pool, uint64_t blockSize, uint32_t blocks, uint64_t reserved, uint64_t largestFree);
+
+        /* Closes the current frame; call once per frame */
+        static void endFrame();
+
+        static int getPoolCount();
+        static const MemoryPoolUsage* getPool(int pool);
+        static const MemoryFrameStats& getLastFrame();
+        static uint64_t getHeapPeak();
+        static bool hooksEnabled();
+
+        /* Adds the heap (and allocation) graphs side by side */
+        static void layout(PerfOverlay& overlay, float x, float y);
+
+        /* Writes pool usage and the recent frame history as CSV */
+        static bool exportCsv(const char* path);
+    };
+} // namespace eXUI
+#endif /* MEMORY_TELEMETRY_HPP */
@@ -1,7 +1,10 @@
 #ifndef PERF_HPP
 #define PERF_HPP
+#include <stdint.h>
 #include <string>
+#include <vector>
 #include <nanovg.h>
+#include "eXUI/damage.hpp"
 
 namespace eXUI
 {
@@ -9,25 +12,115 @@ namespace eXUI
 		FPS,
 		MS,
 		PERCENT,
+		PACING, // frame intervals in vsyncs, see FramePacer
+		COUNT,  // plain per-frame counts, e.g. allocations
 	};
 
 	constexpr int GRAPH_HISTORY_COUNT = 100;
+	constexpr float GRAPH_WIDTH = 200.0f;
+	constexpr float GRAPH_HEIGHT = 35.0f;
+	constexpr float GRAPH_VSYNC_RATE = 60.0f;
+
+	// Log histogram: 8 buckets per octave from GRAPH_HISTOGRAM_MIN up,
+	// bucket 0 collecting everything below (idle zeros included)
+	constexpr int GRAPH_HISTOGRAM_STEPS = 8;
+	constexpr int GRAPH_HISTOGRAM_BUCKETS = 1 + 24 * GRAPH_HISTOGRAM_STEPS;
+	constexpr float GRAPH_HISTOGRAM_MIN = 1.0f / 16384.0f;
+
+	// Statistics over the samples currently in the graph window, in the
+	// unit given to update(). Percentiles are histogram bucket bounds
+	// (within ~9%) clamped to [min, max]; max is the worst frame.
+	struct PerfStats
+	{
+		float average;
+		float min;
+		float max;
+		float p50;
+		float p95;
+		float p99;
+	};
 
 	class PerfGraph
 	{
 	private:
+		// Monotonic deque of (sequence, value) for the windowed min/max
+		struct Extremum
+		{
+			uint32_t seq;
+			float value;
+		};
+
+		struct ExtremumQueue
+		{
+			Extremum items[GRAPH_HISTORY_COUNT];
+			int first;
+			int size;
+		};
+
 		RenderStyle style;
 		std::string name;
 		float values[GRAPH_HISTORY_COUNT];
+		uint8_t buckets[GRAPH_HISTORY_COUNT];
+		uint16_t histogram[GRAPH_HISTOGRAM_BUCKETS];
 		int head;
+		uint32_t count;
+		double sum;
+		ExtremumQueue minQueue;
+		ExtremumQueue maxQueue;
+
+		// Retained overlay state: sample heights as a fraction of the
+		// graph for the current style, and the strings last displayed
+		// along with the quantized values they were formatted from
+		float heights[GRAPH_HISTORY_COUNT];
+		long valueKey, detailKey, tailKey[2];
+		char valueText[32];
+		char detailText[32];
+		char tailText[48];
+
 		float graphAverage();
+		int samples();
+		void pushExtremum(ExtremumQueue& queue, float value, bool keepMax);
+		float sampleHeight(float value);
+		void refreshText();
+
+		friend class PerfOverlay;
 
 	public:
 		PerfGraph(RenderStyle style, std::string name);
 		void update(float frameTime);
+		float percentile(float p);
+		PerfStats getStats();
 		void nextStyle();
 		void render(NVGcontext* vg, float x, float y);
 	};
+
+	// Draws several graphs as one layer: every background and polyline
+	// goes into a single path per fill color, and each text role is
+	// drawn for all graphs under one font state.
+	class PerfOverlay
+	{
+	private:
+		struct Entry
+		{
+			PerfGraph* graph;
+			float x, y;
+		};
+
+		std::vector<Entry> entries;
+		std::vector<Entry> visible;
+
+		static void render(NVGcontext* vg, const Entry* entries, size_t count);
+		friend class PerfGraph;
+
+	public:
+		void clear();
+		void add(PerfGraph* graph, float x, float y);
+		void render(NVGcontext* vg);
+		// Graphs change on every frame they are drawn in
+		void damage(DamageTracker& tracker);
+		// Only the graphs overlapping `clip`
+		void render(NVGcontext* vg, const DamageRect& clip);
+	};
 } // namespace eXUI
 
 #endif /* PERF_HPP */
\ No newline at end of file
@@ -0,0 +1,104 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#if !defined(PROFILER_HPP)
+#define PROFILER_HPP
+#include <switch.h>
+#include <nanovg.h>
+#include "eXUI/perf.hpp"
+
+namespace eXUI
+{
+    constexpr int PROFILER_MAX_ZONES = 32;
+    constexpr int PROFILER_MAX_DEPTH = 16;
+
+    struct ProfilerSample
+    {
+        u64 ns;    /* inclusive time spent in the zone during the frame */
+        u32 calls; /* times the zone was entered during the frame */
+    };
+
+    struct ProfilerZone
+    {
+        const char* name;
+        int parent; /* zone it was first entered under, -1 at the root */
+        int depth;
+        ProfilerSample history[GRAPH_HISTORY_COUNT];
+        int head;
+        u64 frameTicks;
+        u32 frameCalls;
+        PerfGraph* graph;
+    };
+
+    /* CPU zone profiler for the UI thread. Zones are registered once per
+     * call site and accumulate inclusive time until endFrame() moves the
+     * frame's totals into each zone's history and PerfGraph. Use the
+     * EXUI_PROFILE_* macros, which compile out unless EXUI_PROFILER is
+     * defined. */
+    class Profiler
+    {
+    public:
+        static int registerZone(const char* name);
+        static void enter(int zone);
+        static void leave(int zone, u64 ticks);
+        static void endFrame();
+
+        static int getZoneCount();
+        static const ProfilerZone* getZone(int zone);
+
+        /* Adds one graph per zone to the overlay, children indented
+         * under their parents */
+        static void layout(PerfOverlay& overlay, float x, float y);
+    };
+
+    class ProfileScope
+    {
+    public:
+        inline ProfileScope(int zone)
+            : m_zone(zone)
+        {
+            Profiler::enter(zone);
+            this->m_start = armGetSystemTick();
+        }
+
+        inline ~ProfileScope()
+        {
+            Profiler::leave(this->m_zone, armGetSystemTick() - this->m_start);
+        }
+
+    private:
+        int m_zone;
+        u64 m_start;
+    };
+} // namespace eXUI
+
+#define EXUI_PROFILE_CONCAT2(a, b) a##b
+#define EXUI_PROFILE_CONCAT(a, b) EXUI_PROFILE_CONCAT2(a, b)
+
+#if defined(EXUI_PROFILER)
+/* Times the rest of the enclosing scope as zone `name` */
+#define EXUI_PROFILE_ZONE(name) \
+    static const int EXUI_PROFILE_CONCAT(exuiZone, __LINE__) = ::eXUI::Profiler::registerZone(name); \
+    ::eXUI::ProfileScope EXUI_PROFILE_CONCAT(exuiScope, __LINE__)(EXUI_PROFILE_CONCAT(exuiZone, __LINE__))
+/* Closes the current frame; call once per frame outside of any zone */
+#define EXUI_PROFILE_FRAME() ::eXUI::Profiler::endFrame()
+#else
+#define EXUI_PROFILE_ZONE(name) do {} while (0)
+#define EXUI_PROFILE_FRAME() do {} while (0)
+#endif /* EXUI_PROFILER */
+
+#endif /* PROFILER_HPP */
@@ -0,0 +1,98 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#if !defined(RESOLUTION_GOVERNOR_HPP)
+#define RESOLUTION_GOVERNOR_HPP
+#include <switch.h>
+#include "eXUI/frame_pacer.hpp"
+#include "eXUI/perf.hpp"
+
+namespace eXUI
+{
+    // Render heights stepped through, largest first; widths keep 16:9
+    constexpr uint32_t RESOLUTION_STEPS[] = { 1080, 900, 720 };
+    constexpr int RESOLUTION_HISTORY = 16;        // decisions kept
+    constexpr u32 RESOLUTION_WINDOW = 30;         // frames per evaluation
+    constexpr u32 RESOLUTION_UP_COOLDOWN = 120;   // frames before a first step up
+    constexpr u32 RESOLUTION_MAX_COOLDOWN = 3600; // frames, the back-off ceiling
+    constexpr float RESOLUTION_DOWN_LOAD = 0.95f; // of the budget, p95 work above steps down
+    constexpr float RESOLUTION_UP_LOAD = 0.75f;   // p95 work predicted at the next step up
+
+    struct ResolutionDecision
+    {
+        u64 frame;          // rendered frames counted when it was made
+        uint32_t fromHeight;
+        uint32_t toHeight;
+        float workP95;      // ms
+        u32 missedFrames;   // in the window that triggered it
+    };
+
+    /* Dynamic resolution: DkApplication reports how long each rendered
+     * frame kept the CPU busy, and the governor picks the render height.
+     * It steps down once frames miss vsync or the work nears the budget.
+     * It steps up only when the work, scaled by the pixel count of the
+     * next step, would still leave a quarter of the budget spare. A step
+     * up that is undone shortly after doubles the wait before the next
+     * try, so a screen at the edge of the budget settles instead of
+     * oscillating. */
+    class ResolutionGovernor
+    {
+    public:
+        ResolutionGovernor(u64 budget = 16666667);
+
+        // Starts over at full resolution for a new output size
+        void setOutput(uint32_t width, uint32_t height);
+        void setBudget(u64 budget);
+        void setEnabled(bool enabled);
+        bool isEnabled();
+
+        // Once per rendered frame; true when the render size changed
+        bool update(u64 workNs, const FramePacingStats& pacing);
+
+        uint32_t getWidth();
+        uint32_t getHeight();
+        float getScale(); // render height over output height
+        PerfGraph* getGraph();
+
+        // Newest first
+        int getDecisionCount();
+        const ResolutionDecision& getDecision(int index);
+
+    private:
+        uint32_t m_outputWidth, m_outputHeight;
+        int m_steps;      // RESOLUTION_STEPS usable at this output, at least 1
+        int m_first;      // index of the first usable step
+        int m_level;      // current step, 0 = full resolution
+        u64 m_budget;
+        bool m_enabled;
+        u64 m_frames;
+        u64 m_lastChange; // m_frames at the last step
+        u64 m_lastUp;
+        u64 m_missedBase; // pacing.missedFrames at the window start
+        u32 m_window;
+        u32 m_upCooldown;
+        PerfGraph m_graph;
+        ResolutionDecision m_history[RESOLUTION_HISTORY];
+        int m_historyHead;
+        int m_historyCount;
+
+        uint32_t heightAt(int level);
+        void step(int level, float workP95, u32 missed);
+    };
+} // namespace eXUI
+#endif /* RESOLUTION_GOVERNOR_HPP */
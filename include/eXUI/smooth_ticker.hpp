@@ -0,0 +1,76 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#if !defined(SMOOTH_TICKER_HPP)
+#define SMOOTH_TICKER_HPP
+#include <nanovg.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "eXUI/animations.hpp"
+
+namespace eXUI
+{
+    /* Pixel based ticker: the label is measured once per font and
+     * size through NanoVG glyph positions, then scrolled by a
+     * sub-pixel offset every frame inside a scissor rect. Nothing is
+     * re-measured or re-sliced while scrolling, and widths are those
+     * of the actual glyphs (fallback fonts included), not codepoints. */
+    class SmoothTicker
+    {
+    public:
+        SmoothTicker(float speed = 60.0f);
+
+        void setText(std::string_view str, std::string_view spacer = std::string_view());
+        void setType(enum menu_animation_ticker_type type);
+        void reset();
+
+        /* Draws the label vertically centered in the box, using the
+         * given font face and size. Returns whether it is scrolling. */
+        bool render(NVGcontext* vg, AnimationEngine* engine, int font, float fontSize,
+            float x, float y, float width, float height, bool selected);
+
+    private:
+        struct glyph
+        {
+            uint32_t offset; /* byte offset of the glyph in m_text */
+            float x;         /* pen position of the glyph */
+        };
+
+        std::string m_text;
+        std::string m_spacer;
+        enum menu_animation_ticker_type m_type;
+        float m_speed; /* px per second */
+
+        /* Measurement cache, valid for m_font at m_fontSize */
+        bool m_measured;
+        int m_font;
+        float m_fontSize;
+        float m_textWidth;
+        float m_spacerWidth;
+        float m_ellipsisWidth;
+        std::vector<glyph> m_glyphs;
+
+        float m_time; /* ms spent scrolling */
+        bool m_selected;
+
+        void measure(NVGcontext* vg, int font, float fontSize);
+        float offset(float width);
+        const char* truncate(float width);
+    };
+} // namespace eXUI
+#endif /* SMOOTH_TICKER_HPP */
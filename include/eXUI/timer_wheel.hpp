@@ -0,0 +1,351 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#if !defined(TIMER_WHEEL_HPP)
+#define TIMER_WHEEL_HPP
+#include <stdint.h>
+#include <vector>
+
+namespace eXUI
+{
+    /* Node index in the low 32 bits, node generation in the high 32 bits */
+    typedef uint64_t timer_wheel_handle_t;
+
+    #define TIMER_WHEEL_INVALID_HANDLE ((timer_wheel_handle_t)0)
+
+    /* Hierarchical timing wheel with 1 ms ticks: 4 levels of 64 slots
+     * cover 2^24 ms (~4.6 hours), later deadlines are parked on the
+     * last level and re-inserted until they come in range.
+     *
+     * Nodes live in a pool that is reused, and each slot is an intrusive
+     * doubly linked list of node indices, so schedule() and cancel()
+     * are O(1) and pending timers cost nothing until their slot comes
+     * up. Expired nodes are handed back to the caller, which reads the
+     * payload and then release()s them. */
+    template <typename T>
+    class TimerWheel
+    {
+    public:
+        struct Node
+        {
+            int64_t expires;
+            uint32_t prev;
+            uint32_t next;
+            uint32_t generation;
+            uint8_t state;
+            uint8_t level;
+            uint8_t slot;
+            T payload;
+        };
+
+        TimerWheel();
+
+        uint32_t allocate();
+        void release(uint32_t id);
+        Node& get(uint32_t id);
+
+        timer_wheel_handle_t schedule(uint32_t id, int64_t expires);
+        bool cancel(timer_wheel_handle_t handle);
+        bool isCancelled(uint32_t id);
+
+        void start(int64_t now);
+        void advance(int64_t now, std::vector<uint32_t>& expired);
+        void clear();
+        size_t size();
+
+    private:
+        static constexpr unsigned Bits     = 6;
+        static constexpr unsigned Slots    = 1 << Bits;
+        static constexpr unsigned Mask     = Slots - 1;
+        static constexpr unsigned Levels   = 4;
+        static constexpr uint32_t Nil      = 0xFFFFFFFF;
+
+        enum NodeState : uint8_t
+        {
+            Free = 0,
+            Linked,
+            Expired,
+            Cancelled
+        };
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_free;
+        uint32_t m_heads[Levels][Slots];
+        size_t m_levelCount[Levels];
+        size_t m_count;
+        int64_t m_time;
+        bool m_started;
+
+        void link(uint32_t id);
+        void unlink(uint32_t id);
+        void cascade(unsigned level);
+    };
+
+    template <typename T>
+    TimerWheel<T>::TimerWheel()
+        : m_count(0), m_time(0), m_started(false)
+    {
+        for (unsigned level = 0; level < Levels; level++)
+        {
+            this->m_levelCount[level] = 0;
+            for (unsigned slot = 0; slot < Slots; slot++)
+                this->m_heads[level][slot] = Nil;
+        }
+    }
+
+    template <typename T>
+    uint32_t TimerWheel<T>::allocate()
+    {
+        uint32_t id;
+
+        if (this->m_free.size() > 0)
+        {
+            id = this->m_free.back();
+            this->m_free.pop_back();
+        }
+        else
+        {
+            id = (uint32_t)this->m_nodes.size();
+            this->m_nodes.emplace_back();
+            this->m_nodes[id].generation = 1;
+        }
+
+        this->m_nodes[id].state = Free;
+        return id;
+    }
+
+    template <typename T>
+    void TimerWheel<T>::release(uint32_t id)
+    {
+        Node& node = this->m_nodes[id];
+
+        if (node.state == Linked)
+            this->unlink(id);
+
+        node.state   = Free;
+        node.payload = T();
+        if (++node.generation == 0)
+            node.generation = 1;
+
+        this->m_free.push_back(id);
+    }
+
+    template <typename T>
+    typename TimerWheel<T>::Node& TimerWheel<T>::get(uint32_t id)
+    {
+        return this->m_nodes[id];
+    }
+
+    template <typename T>
+    timer_wheel_handle_t TimerWheel<T>::schedule(uint32_t id, int64_t expires)
+    {
+        Node& node = this->m_nodes[id];
+
+        /* A deadline in the past fires on the next advance() */
+        node.expires = expires > this->m_time ? expires : this->m_time + 1;
+        this->link(id);
+
+        return ((timer_wheel_handle_t)node.generation << 32) | id;
+    }
+
+    template <typename T>
+    bool TimerWheel<T>::cancel(timer_wheel_handle_t handle)
+    {
+        uint32_t id = (uint32_t)(handle & 0xFFFFFFFF);
+
+        if (handle == TIMER_WHEEL_INVALID_HANDLE || id >= this->m_nodes.size())
+            return false;
+
+        Node& node = this->m_nodes[id];
+
+        if (node.generation != (uint32_t)(handle >> 32))
+            return false;
+
+        switch (node.state)
+        {
+            case Linked:
+                this->release(id);
+                return true;
+            case Expired:
+                /* Already handed out by advance(), the caller releases it */
+                node.state = Cancelled;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    template <typename T>
+    bool TimerWheel<T>::isCancelled(uint32_t id)
+    {
+        return this->m_nodes[id].state == Cancelled;
+    }
+
+    template <typename T>
+    void TimerWheel<T>::start(int64_t now)
+    {
+        if (this->m_started)
+            return;
+
+        this->m_time    = now;
+        this->m_started = true;
+    }
+
+    template <typename T>
+    void TimerWheel<T>::advance(int64_t now, std::vector<uint32_t>& expired)
+    {
+        if (!this->m_started)
+        {
+            this->start(now);
+            return;
+        }
+
+        while (this->m_time < now)
+        {
+            uint32_t id;
+
+            if (this->m_count == 0)
+            {
+                this->m_time = now;
+                break;
+            }
+
+            /* Nothing due on the first level: jump straight to the
+             * next cascade point instead of stepping every tick */
+            if (this->m_levelCount[0] == 0)
+            {
+                int64_t boundary = (this->m_time | Mask) + 1;
+
+                if (boundary > now)
+                {
+                    this->m_time = now;
+                    break;
+                }
+
+                this->m_time = boundary - 1;
+            }
+
+            this->m_time++;
+
+            if ((this->m_time & Mask) == 0)
+                this->cascade(1);
+
+            while ((id = this->m_heads[0][this->m_time & Mask]) != Nil)
+            {
+                this->unlink(id);
+                this->m_nodes[id].state = Expired;
+                expired.push_back(id);
+            }
+        }
+    }
+
+    template <typename T>
+    void TimerWheel<T>::clear()
+    {
+        for (uint32_t id = 0; id < this->m_nodes.size(); id++)
+        {
+            if (this->m_nodes[id].state != Free)
+                this->release(id);
+        }
+    }
+
+    template <typename T>
+    size_t TimerWheel<T>::size()
+    {
+        return this->m_count;
+    }
+
+    template <typename T>
+    void TimerWheel<T>::link(uint32_t id)
+    {
+        Node& node    = this->m_nodes[id];
+        int64_t delta = node.expires - this->m_time;
+        int64_t at    = node.expires;
+        unsigned level;
+
+        if (delta < 0)
+        {
+            delta = 0;
+            at    = this->m_time;
+        }
+
+        for (level = 0; level < Levels - 1; level++)
+        {
+            if (delta < ((int64_t)1 << (Bits * (level + 1))))
+                break;
+        }
+
+        /* Out of range, park it as far as the last level reaches */
+        if (delta >= ((int64_t)1 << (Bits * Levels)))
+            at = this->m_time + ((int64_t)1 << (Bits * Levels)) - 1;
+
+        node.state = Linked;
+        node.level = (uint8_t)level;
+        node.slot  = (uint8_t)((at >> (Bits * level)) & Mask);
+        node.prev  = Nil;
+        node.next  = this->m_heads[level][node.slot];
+
+        if (node.next != Nil)
+            this->m_nodes[node.next].prev = id;
+
+        this->m_heads[level][node.slot] = id;
+        this->m_levelCount[level]++;
+        this->m_count++;
+    }
+
+    template <typename T>
+    void TimerWheel<T>::unlink(uint32_t id)
+    {
+        Node& node = this->m_nodes[id];
+
+        if (node.prev != Nil)
+            this->m_nodes[node.prev].next = node.next;
+        else
+            this->m_heads[node.level][node.slot] = node.next;
+
+        if (node.next != Nil)
+            this->m_nodes[node.next].prev = node.prev;
+
+        node.prev = node.next = Nil;
+        this->m_levelCount[node.level]--;
+        this->m_count--;
+    }
+
+    /* Moves every node of the current slot of `level` down to the
+     * levels below, wrapping into the next level first if needed */
+    template <typename T>
+    void TimerWheel<T>::cascade(unsigned level)
+    {
+        unsigned slot;
+        uint32_t id;
+
+        if (level >= Levels)
+            return;
+
+        slot = (this->m_time >> (Bits * level)) & Mask;
+
+        while ((id = this->m_heads[level][slot]) != Nil)
+        {
+            this->unlink(id);
+            this->link(id);
+        }
+
+        if (slot == 0)
+            this->cascade(level + 1);
+    }
+} // namespace eXUI
+#endif /* TIMER_WHEEL_HPP */
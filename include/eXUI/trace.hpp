@@ -0,0 +1,61 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#if !defined(TRACE_HPP)
+#define TRACE_HPP
+#include <stdint.h>
+#include <atomic>
+
+namespace eXUI
+{
+    /* Events per thread buffered between two writer passes; producers
+     * drop (and count) events when their ring is full */
+    constexpr uint32_t TRACE_RING_SIZE = 4096;
+    constexpr int TRACE_MESSAGE_SIZE = 48;
+
+    static constexpr const char* TraceDefaultPath = "sdmc:/eXUI.trace.json";
+
+    /* Timeline capture in the Chrome trace-event JSON format, which
+     * Perfetto and chrome://tracing load directly. Each thread records
+     * into its own lock-free single-producer ring; a background thread
+     * drains every ring into the file, so recording never touches the
+     * filesystem. Event names must be string literals (or otherwise
+     * outlive the capture), only instant messages are copied. */
+    class Trace
+    {
+    public:
+        static bool start(const char* path);
+        static void stop();
+
+        inline static bool isActive()
+        {
+            return Trace::active.load(std::memory_order_relaxed);
+        }
+
+        /* Names the calling thread in the capture */
+        static void setThreadName(const char* name);
+
+        static void begin(const char* name);
+        static void end(const char* name);
+        static void instant(const char* name, const char* message);
+        static void counter(const char* name, int64_t value);
+
+    private:
+        inline static std::atomic<bool> active = false;
+    };
+} // namespace eXUI
+#endif /* TRACE_HPP */
@@ -1,6 +1,9 @@
 #if !defined(UI_STATE_HPP)
 #define UI_STATE_HPP
 #include <nanovg_dk.h>
+#include "eXUI/animations.hpp"
+#include "eXUI/frame_pacer.hpp"
+#include "eXUI/input_log.hpp"
 #include "eXUI/perf.hpp"
 
 namespace eXUI
@@ -25,14 +28,37 @@ namespace eXUI
         uint32_t m_w, m_h;
         FontStash *m_fontStash;
         PerfGraph *m_fps;
+        PerfOverlay m_overlay;
+        FramePacer *m_pacer;
+        AnimationEngine *m_animations;
         PadState m_pad;
+        InputRecorder *m_recorder;
+        InputReplayer *m_replayer;
+        u64 m_frameNs;
       	float m_prevTime;
+        bool m_dirty;
+        bool m_rendered;
+        bool m_resumed;
+        DamageTracker m_damage;
+        const DamageRegion *m_region;
+        bool m_flashDamage;
 
     public:
         DkUIState(nvg::DkRenderer *renderer, uint32_t w = 1280, uint32_t h = 720);
         ~DkUIState();
+        const DamageRegion &beginFrame(unsigned slot);
 		void render(u64 ns, float fbW, float fbH);
         bool onFrame(u64 ns);
+        AnimationEngine *getAnimations();
+        void setFramePacer(FramePacer *pacer);
+        void setInputRecorder(InputRecorder *recorder);
+        void setInputReplayer(InputReplayer *replayer);
+        u64 getFrameTime();
+        void invalidate();
+        void invalidate(float x, float y, float w, float h);
+        void invalidateBuffers();
+        void setDamageFlash(bool enabled);
+        bool isDirty();
     };
 } // namespace eXUI
 #endif /* UI_STATE_HPP */
\ No newline at end of file
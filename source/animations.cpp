@@ -17,6 +17,7 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "eXUI/animations.hpp"
+#include "eXUI/trace.hpp"
 
 #include <compat/strl.h>
 #include <encodings/utf.h>
@@ -28,52 +29,37 @@
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
+#include <utility>
 #include <vector>
 
 namespace eXUI
 {
-    struct tween
-    {
-        float duration;
-        float running_since;
-        float initial_value;
-        float target_value;
-        float* subject;
-        uintptr_t tag;
-        easing_cb easing;
-        tween_cb cb;
-        tween_cb tick;
-        void* userdata;
-        bool deleted;
-    };
-
-    struct menu_animation
-    {
-        std::vector<tween> list;
-        std::vector<tween> pending;
-        bool pending_deletes;
-        bool in_update;
-    };
-
-    typedef struct menu_animation menu_animation_t;
-
     #define TICKER_SPEED 333
     #define TICKER_SLOW_SPEED 1600
 
     static const char ticker_spacer_default[] = "   |   ";
 
-    static menu_animation_t anim;
-    static retro_time_t cur_time    = 0;
-    static retro_time_t old_time    = 0;
-    static uint64_t ticker_idx      = 0; /* updated every TICKER_SPEED ms */
-    static uint64_t ticker_slow_idx = 0; /* updated every TICKER_SLOW_SPEED ms */
-    static float delta_time         = 0.0f;
-    static bool animation_is_active = false;
-    static bool ticker_is_active    = false;
+    static AnimationEngine* default_engine = NULL;
+
+    #define HANDLE_SLOT(handle)       ((uint32_t)((handle) & 0xFFFFFFFF))
+    #define HANDLE_GENERATION(handle) ((uint32_t)((handle) >> 32))
+    #define MAKE_HANDLE(slot, generation) \
+        (((menu_animation_handle_t)(generation) << 32) | (menu_animation_handle_t)(slot))
 
-    static double highlight_gradient_x = 0.0f;
-    static double highlight_gradient_y = 0.0f;
-    static double highlight_color      = 0.0f;
+    template <typename K>
+    static void menu_animation_index_erase(std::unordered_multimap<K, uint32_t>& index, K key, uint32_t slot)
+    {
+        auto range = index.equal_range(key);
+
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == slot)
+            {
+                index.erase(it);
+                return;
+            }
+        }
+    }
 
     /* from https://github.com/kikito/tween.lua/blob/master/tween.lua */
 
@@ -303,6 +289,89 @@ namespace eXUI
         return easing_in_bounce((t * 2) - d, b + c / 2, c / 2, d);
     }
 
+    /* Reference easing functions, indexed by menu_animation_easing_type */
+    static const easing_cb easing_funcs[EASING_LAST] =
+    {
+        &easing_linear,
+        &easing_in_quad,   &easing_out_quad,   &easing_in_out_quad,   &easing_out_in_quad,
+        &easing_in_cubic,  &easing_out_cubic,  &easing_in_out_cubic,  &easing_out_in_cubic,
+        &easing_in_quart,  &easing_out_quart,  &easing_in_out_quart,  &easing_out_in_quart,
+        &easing_in_quint,  &easing_out_quint,  &easing_in_out_quint,  &easing_out_in_quint,
+        &easing_in_sine,   &easing_out_sine,   &easing_in_out_sine,   &easing_out_in_sine,
+        &easing_in_expo,   &easing_out_expo,   &easing_in_out_expo,   &easing_out_in_expo,
+        &easing_in_circ,   &easing_out_circ,   &easing_in_out_circ,   &easing_out_in_circ,
+        &easing_in_bounce, &easing_out_bounce, &easing_in_out_bounce, &easing_out_in_bounce,
+        /* EASING_SPRING is integrated by AnimationEngine::springGroup() */
+    };
+
+    /* Batched easing: four tweens per call on normalized progress
+     * u = t / d in [0, 1], returning the eased fraction of the way
+     * to the target. GCC lowers the vector type to NEON on the
+     * Switch (and SSE on x86 hosts). Only the polynomial families
+     * have batched forms; the others go through easing_funcs. */
+    typedef float easing_v4 __attribute__((vector_size(4 * sizeof(float))));
+    typedef easing_v4 (*easing_batch_cb)(easing_v4);
+
+    #define EASING_BATCH_WIDTH 4
+
+    template <int N>
+    static inline easing_v4 easing_pow_v4(easing_v4 x)
+    {
+        easing_v4 r = x;
+        for (int i = 1; i < N; i++)
+            r *= x;
+        return r;
+    }
+
+    static easing_v4 easing_batch_linear(easing_v4 u)
+    {
+        return u;
+    }
+
+    template <int N>
+    static easing_v4 easing_batch_in(easing_v4 u)
+    {
+        return easing_pow_v4<N>(u);
+    }
+
+    template <int N>
+    static easing_v4 easing_batch_out(easing_v4 u)
+    {
+        return 1.0f - easing_pow_v4<N>(1.0f - u);
+    }
+
+    template <int N>
+    static easing_v4 easing_batch_in_out(easing_v4 u)
+    {
+        easing_v4 in  = 0.5f * easing_pow_v4<N>(2.0f * u);
+        easing_v4 out = 1.0f - 0.5f * easing_pow_v4<N>(2.0f - 2.0f * u);
+        return u < 0.5f ? in : out;
+    }
+
+    template <int N>
+    static easing_v4 easing_batch_out_in(easing_v4 u)
+    {
+        easing_v4 out = 0.5f * easing_batch_out<N>(2.0f * u);
+        easing_v4 in  = 0.5f + 0.5f * easing_batch_in<N>(2.0f * u - 1.0f);
+        return u < 0.5f ? out : in;
+    }
+
+    static const easing_batch_cb easing_batch_funcs[EASING_LAST] =
+    {
+        &easing_batch_linear,
+        &easing_batch_in<2>, &easing_batch_out<2>, &easing_batch_in_out<2>, &easing_batch_out_in<2>,
+        &easing_batch_in<3>, &easing_batch_out<3>, &easing_batch_in_out<3>, &easing_batch_out_in<3>,
+        &easing_batch_in<4>, &easing_batch_out<4>, &easing_batch_in_out<4>, &easing_batch_out_in<4>,
+        &easing_batch_in<5>, &easing_batch_out<5>, &easing_batch_in_out<5>, &easing_batch_out_in<5>,
+        /* Sine, Expo, Circ and Bounce use the reference functions */
+    };
+
+    /* For a critically damped spring starting at rest, the remaining
+     * distance after t is (1 + wt) * e^(-wt); it drops to 0.1% at
+     * wt ~= 9.23, so w = SPRING_SETTLE / duration settles in `duration` */
+    #define SPRING_SETTLE 9.23f
+    #define SPRING_EPSILON 0.001f
+
     static void menu_animation_ticker_generic(uint64_t idx,
         size_t max_width, size_t* offset, size_t* width)
     {
@@ -385,316 +454,580 @@ namespace eXUI
         *width3  = width;
     }
 
-    void menu_animation_init(void)
+    static int64_t menu_animation_default_clock(void)
     {
-        // Nothing to do
+        return cpu_features_get_time_usec();
     }
 
-    void menu_animation_free(void)
+    AnimationEngine::AnimationEngine(animation_clock_cb clock)
+        : m_clock(clock ? clock : animation_clock_cb(menu_animation_default_clock)),
+        m_pendingDeletes(false),
+        m_inUpdate(false),
+        m_clears(0),
+        m_curTime(0),
+        m_oldTime(0),
+        m_lastClockUpdate(0),
+        m_lastTickerUpdate(0),
+        m_lastTickerSlowUpdate(0),
+        m_tickerIdx(0),
+        m_tickerSlowIdx(0),
+        m_deltaTime(0.0f),
+        m_animationIsActive(false),
+        m_tickerIsActive(false),
+        m_highlightGradientX(0.0),
+        m_highlightGradientY(0.0),
+        m_highlightColor(0.0)
     {
-        anim.list.clear();
-        anim.pending.clear();
+    }
 
-        anim.in_update       = false;
-        anim.pending_deletes = false;
+    AnimationEngine::~AnimationEngine()
+    {
+        if (default_engine == this)
+            default_engine = NULL;
     }
 
-    static void menu_delayed_animation_cb(void* userdata)
+    AnimationEngine* AnimationEngine::getDefault()
     {
-        menu_delayed_animation_t* delayed_animation = (menu_delayed_animation_t*)userdata;
+        static AnimationEngine fallback;
 
-        menu_animation_push(&delayed_animation->entry);
+        return default_engine ? default_engine : &fallback;
+    }
 
-        free(delayed_animation);
+    void AnimationEngine::setDefault(AnimationEngine* engine)
+    {
+        default_engine = engine;
     }
 
-    void menu_animation_push_delayed(unsigned delay, menu_animation_ctx_entry_t* entry)
+    void AnimationEngine::clear()
     {
-        menu_timer_ctx_entry_t timer_entry;
-        menu_delayed_animation_t* delayed_animation = (menu_delayed_animation_t*)malloc(sizeof(menu_delayed_animation_t));
+        uint32_t slot;
+
+        this->m_hot.clear();
+        this->m_cold.clear();
+        this->m_deleted.clear();
+        this->m_tagIndex.clear();
+        this->m_subjectIndex.clear();
+        this->m_timers.clear();
+        this->m_timerHandles.clear();
+
+        /* Invalidate every outstanding handle */
+        this->m_freeSlots.clear();
+        for (slot = 0; slot < this->m_slots.size(); slot++)
+        {
+            if (++this->m_slots[slot].generation == 0)
+                this->m_slots[slot].generation = 1;
+            this->m_freeSlots.push_back(slot);
+        }
 
-        delayed_animation->entry.cb           = entry->cb;
-        delayed_animation->entry.duration     = entry->duration;
-        delayed_animation->entry.easing_enum  = entry->easing_enum;
-        delayed_animation->entry.subject      = entry->subject;
-        delayed_animation->entry.tag          = entry->tag;
-        delayed_animation->entry.target_value = entry->target_value;
-        delayed_animation->entry.tick         = entry->tick;
-        delayed_animation->entry.userdata     = entry->userdata;
+        /* m_inUpdate stays set when a callback clears from inside
+         * update(), so kills of tweens it pushes afterwards are
+         * still deferred to the compaction pass */
+        this->m_pendingDeletes = false;
+        this->m_clears++;
+    }
 
-        timer_entry.cb       = menu_delayed_animation_cb;
-        timer_entry.tick     = NULL;
-        timer_entry.duration = delay;
-        timer_entry.userdata = delayed_animation;
+    /* Evaluates `count` tweens of the same easing type, writing
+     * the eased value to each subject */
+    void AnimationEngine::easeGroup(uint8_t type, const uint32_t* indices, size_t count)
+    {
+        if (type == EASING_SPRING)
+        {
+            this->springGroup(indices, count);
+            return;
+        }
+
+        easing_batch_cb batch = easing_batch_funcs[type];
+        easing_cb scalar      = easing_funcs[type];
+        size_t i, k;
+
+        if (!batch)
+        {
+            for (i = 0; i < count; i++)
+            {
+                struct tween_hot* tween = &this->m_hot[indices[i]];
+                *tween->subject = scalar(
+                    tween->running_since,
+                    tween->initial_value,
+                    tween->target_value - tween->initial_value,
+                    tween->duration);
+            }
+            return;
+        }
 
-        menu_timer_start(&delayed_animation->timer, &timer_entry);
+        for (i = 0; i < count; i += EASING_BATCH_WIDTH)
+        {
+            size_t lanes = count - i < EASING_BATCH_WIDTH ? count - i : EASING_BATCH_WIDTH;
+            easing_v4 t = { 0.0f, 0.0f, 0.0f, 0.0f };
+            easing_v4 d = { 1.0f, 1.0f, 1.0f, 1.0f };
+            easing_v4 u, e;
+
+            for (k = 0; k < lanes; k++)
+            {
+                const struct tween_hot* tween = &this->m_hot[indices[i + k]];
+                t[k] = tween->running_since;
+                d[k] = tween->duration;
+            }
+
+            u = t / d;
+            u = u > 1.0f ? 1.0f : u;
+            e = batch(u);
+
+            for (k = 0; k < lanes; k++)
+            {
+                struct tween_hot* tween = &this->m_hot[indices[i + k]];
+                *tween->subject = tween->initial_value + (tween->target_value - tween->initial_value) * e[k];
+            }
+        }
     }
 
-    bool menu_animation_push(menu_animation_ctx_entry_t* entry)
+    /* Returns the hot/cold index of a live tween, or -1 */
+    int64_t AnimationEngine::find(menu_animation_handle_t handle)
     {
-        struct tween t;
+        uint32_t slot = HANDLE_SLOT(handle);
+        uint32_t index;
+
+        if (handle == MENU_ANIMATION_INVALID_HANDLE || slot >= this->m_slots.size())
+            return -1;
+
+        if (this->m_slots[slot].generation != HANDLE_GENERATION(handle))
+            return -1;
+
+        index = this->m_slots[slot].index;
+
+        return this->m_deleted[index] ? -1 : (int64_t)index;
+    }
+
+    /* Steps springs by the frame delta with the exact solution of
+     * x'' = -2w x' - w^2 x, so large frame times stay stable. A spring
+     * that has settled snaps to its target with zero velocity. */
+    void AnimationEngine::springGroup(const uint32_t* indices, size_t count)
+    {
+        float dt = this->m_deltaTime;
+        size_t i;
+
+        for (i = 0; i < count; i++)
+        {
+            struct tween_hot* tween = &this->m_hot[indices[i]];
+            float w        = SPRING_SETTLE / tween->duration;
+            float x        = *tween->subject - tween->target_value;
+            float v        = tween->velocity;
+            float c        = v + w * x;
+            float e        = expf(-w * dt);
+            float span     = fabsf(tween->target_value - tween->initial_value);
+            float epsilon  = SPRING_EPSILON * (span > 1.0f ? span : 1.0f);
+
+            x = (x + c * dt) * e;
+            v = (v - w * c * dt) * e;
+
+            /* settled when both the distance and a 60 Hz frame's worth
+             * of movement are below the threshold */
+            if (fabsf(x) < epsilon && fabsf(v) * 16.67f < epsilon)
+            {
+                x = 0.0f;
+                v = 0.0f;
+            }
+
+            *tween->subject = tween->target_value + x;
+            tween->velocity = v;
+        }
+    }
+
+    static bool tween_is_finished(const struct tween_hot* tween)
+    {
+        if (tween->easing == EASING_SPRING)
+            return tween->velocity == 0.0f && *tween->subject == tween->target_value;
+
+        return tween->running_since >= tween->duration;
+    }
+
+    /* O(1) removal: move the last tween into index i */
+    void AnimationEngine::removeAt(size_t i)
+    {
+        size_t last    = this->m_hot.size() - 1;
+        uint32_t slot  = this->m_cold[i].slot;
+
+        if (this->m_cold[i].tag != (uintptr_t)-1)
+            menu_animation_index_erase(this->m_tagIndex, this->m_cold[i].tag, slot);
+        menu_animation_index_erase(this->m_subjectIndex, this->m_hot[i].subject, slot);
+
+        if (++this->m_slots[slot].generation == 0)
+            this->m_slots[slot].generation = 1;
+        this->m_freeSlots.push_back(slot);
+
+        if (i != last)
+        {
+            this->m_hot[i]     = this->m_hot[last];
+            this->m_cold[i]    = std::move(this->m_cold[last]);
+            this->m_deleted[i] = this->m_deleted[last];
+            this->m_slots[this->m_cold[i].slot].index = (uint32_t)i;
+        }
+
+        this->m_hot.pop_back();
+        this->m_cold.pop_back();
+        this->m_deleted.pop_back();
+    }
+
+    /* Kills tween i, deferring the removal to the end of
+     * update() if we are currently inside it */
+    void AnimationEngine::killAt(size_t i)
+    {
+        if (this->m_inUpdate)
+        {
+            this->m_deleted[i]     = true;
+            this->m_pendingDeletes = true;
+        }
+        else
+            this->removeAt(i);
+    }
+
+    void AnimationEngine::pushDelayed(unsigned delay, menu_animation_ctx_entry_t* entry)
+    {
+        uint32_t id = this->m_timers.allocate();
+        menu_timer_payload& payload = this->m_timers.get(id).payload;
+
+        payload.timer   = NULL;
+        payload.delayed = true;
+        payload.entry   = *entry;
+
+        this->m_timers.start(this->timerNow());
+        this->m_timers.schedule(id, this->timerNow() + delay);
+    }
+
+    menu_animation_handle_t AnimationEngine::push(menu_animation_ctx_entry_t* entry)
+    {
+        struct tween_hot t;
+        struct tween_cold c;
+        uint32_t slot;
 
         t.duration      = entry->duration;
         t.running_since = 0;
         t.initial_value = *entry->subject;
         t.target_value  = entry->target_value;
         t.subject       = entry->subject;
-        t.tag           = entry->tag;
-        t.cb            = entry->cb;
-        t.tick          = entry->tick;
-        t.userdata      = entry->userdata;
-        t.easing        = NULL;
-        t.deleted       = false;
+        t.velocity      = 0.0f;
+        c.tag           = entry->tag;
+        c.cb            = entry->cb;
+        c.tick          = entry->tick;
+        c.userdata      = entry->userdata;
+
+        if ((unsigned)entry->easing_enum < EASING_LAST)
+            t.easing = (uint8_t)entry->easing_enum;
+        else
+            return MENU_ANIMATION_INVALID_HANDLE;
 
-        switch (entry->easing_enum)
+        /* ignore born dead tweens */
+        if (t.duration == 0 || t.initial_value == t.target_value)
+            return MENU_ANIMATION_INVALID_HANDLE;
+
+        if (this->m_freeSlots.size() > 0)
         {
-            case EASING_LINEAR:
-                t.easing = &easing_linear;
-                break;
-                /* Quad */
-            case EASING_IN_QUAD:
-                t.easing = &easing_in_quad;
-                break;
-            case EASING_OUT_QUAD:
-                t.easing = &easing_out_quad;
-                break;
-            case EASING_IN_OUT_QUAD:
-                t.easing = &easing_in_out_quad;
-                break;
-            case EASING_OUT_IN_QUAD:
-                t.easing = &easing_out_in_quad;
-                break;
-                /* Cubic */
-            case EASING_IN_CUBIC:
-                t.easing = &easing_in_cubic;
-                break;
-            case EASING_OUT_CUBIC:
-                t.easing = &easing_out_cubic;
-                break;
-            case EASING_IN_OUT_CUBIC:
-                t.easing = &easing_in_out_cubic;
-                break;
-            case EASING_OUT_IN_CUBIC:
-                t.easing = &easing_out_in_cubic;
-                break;
-                /* Quart */
-            case EASING_IN_QUART:
-                t.easing = &easing_in_quart;
-                break;
-            case EASING_OUT_QUART:
-                t.easing = &easing_out_quart;
-                break;
-            case EASING_IN_OUT_QUART:
-                t.easing = &easing_in_out_quart;
-                break;
-            case EASING_OUT_IN_QUART:
-                t.easing = &easing_out_in_quart;
-                break;
-                /* Quint */
-            case EASING_IN_QUINT:
-                t.easing = &easing_in_quint;
-                break;
-            case EASING_OUT_QUINT:
-                t.easing = &easing_out_quint;
-                break;
-            case EASING_IN_OUT_QUINT:
-                t.easing = &easing_in_out_quint;
-                break;
-            case EASING_OUT_IN_QUINT:
-                t.easing = &easing_out_in_quint;
-                break;
-                /* Sine */
-            case EASING_IN_SINE:
-                t.easing = &easing_in_sine;
-                break;
-            case EASING_OUT_SINE:
-                t.easing = &easing_out_sine;
-                break;
-            case EASING_IN_OUT_SINE:
-                t.easing = &easing_in_out_sine;
-                break;
-            case EASING_OUT_IN_SINE:
-                t.easing = &easing_out_in_sine;
-                break;
-                /* Expo */
-            case EASING_IN_EXPO:
-                t.easing = &easing_in_expo;
-                break;
-            case EASING_OUT_EXPO:
-                t.easing = &easing_out_expo;
-                break;
-            case EASING_IN_OUT_EXPO:
-                t.easing = &easing_in_out_expo;
-                break;
-            case EASING_OUT_IN_EXPO:
-                t.easing = &easing_out_in_expo;
-                break;
-                /* Circ */
-            case EASING_IN_CIRC:
-                t.easing = &easing_in_circ;
-                break;
-            case EASING_OUT_CIRC:
-                t.easing = &easing_out_circ;
-                break;
-            case EASING_IN_OUT_CIRC:
-                t.easing = &easing_in_out_circ;
-                break;
-            case EASING_OUT_IN_CIRC:
-                t.easing = &easing_out_in_circ;
-                break;
-                /* Bounce */
-            case EASING_IN_BOUNCE:
-                t.easing = &easing_in_bounce;
-                break;
-            case EASING_OUT_BOUNCE:
-                t.easing = &easing_out_bounce;
-                break;
-            case EASING_IN_OUT_BOUNCE:
-                t.easing = &easing_in_out_bounce;
-                break;
-            case EASING_OUT_IN_BOUNCE:
-                t.easing = &easing_out_in_bounce;
-                break;
-            default:
-                break;
+            slot = this->m_freeSlots.back();
+            this->m_freeSlots.pop_back();
+        }
+        else
+        {
+            slot = (uint32_t)this->m_slots.size();
+            this->m_slots.push_back({ 0, 1 });
         }
 
-        /* ignore born dead tweens */
-        if (!t.easing || t.duration == 0 || t.initial_value == t.target_value)
+        c.slot = slot;
+        this->m_slots[slot].index = (uint32_t)this->m_hot.size();
+
+        if (c.tag != (uintptr_t)-1)
+            this->m_tagIndex.emplace(c.tag, slot);
+        this->m_subjectIndex.emplace(t.subject, slot);
+
+        /* Tweens pushed during update() are appended past the
+         * range being updated and start on the next frame */
+        this->m_hot.push_back(t);
+        this->m_cold.push_back(std::move(c));
+        this->m_deleted.push_back(false);
+
+        return MAKE_HANDLE(slot, this->m_slots[slot].generation);
+    }
+
+    bool AnimationEngine::kill(menu_animation_handle_t handle)
+    {
+        int64_t index = this->find(handle);
+
+        if (index < 0)
             return false;
 
-        if (anim.in_update)
-            anim.pending.push_back(t);
-        else
-            anim.list.push_back(t);
+        this->killAt((size_t)index);
+        return true;
+    }
+
+    /* Points a live tween at a new target in place, without touching
+     * its callbacks. Eased tweens restart their curve from the current
+     * value; springs keep their current velocity. A duration <= 0
+     * keeps the current one. */
+    bool AnimationEngine::retarget(menu_animation_handle_t handle, float target_value, float duration)
+    {
+        int64_t index = this->find(handle);
+        struct tween_hot* tween;
+
+        if (index < 0)
+            return false;
+
+        tween = &this->m_hot[index];
+        tween->initial_value = *tween->subject;
+        tween->target_value  = target_value;
+        tween->running_since = 0;
+
+        if (duration > 0)
+            tween->duration = duration;
 
         return true;
     }
 
-    void menu_animation_get_highlight(float* gradient_x, float* gradient_y, float* color)
+    bool AnimationEngine::getProgress(menu_animation_handle_t handle, float* progress)
+    {
+        int64_t index = this->find(handle);
+        float p;
+
+        if (index < 0)
+            return false;
+
+        p = this->m_hot[index].running_since / this->m_hot[index].duration;
+
+        if (progress)
+            *progress = p > 1.0f ? 1.0f : p;
+
+        return true;
+    }
+
+    bool AnimationEngine::isAlive(menu_animation_handle_t handle)
+    {
+        return this->find(handle) >= 0;
+    }
+
+    void AnimationEngine::getHighlight(float* gradient_x, float* gradient_y, float* color)
     {
         if (gradient_x)
-            *gradient_x = (float)highlight_gradient_x;
+            *gradient_x = (float)this->m_highlightGradientX;
 
         if (gradient_y)
-            *gradient_y = (float)highlight_gradient_y;
+            *gradient_y = (float)this->m_highlightGradientY;
 
         if (color)
-            *color = (float)highlight_color;
+            *color = (float)this->m_highlightColor;
     }
 
     #define HIGHLIGHT_SPEED 350.0
 
-    static void menu_animation_update_time(bool timedate_enable)
+    void AnimationEngine::updateTime(bool timedate_enable)
     {
-        static retro_time_t
-            last_clock_update
-            = 0;
-        static retro_time_t
-            last_ticker_update
-            = 0;
-        static retro_time_t
-            last_ticker_slow_update
-            = 0;
-
         /* Adjust ticker speed */
         float speed_factor         = 1.0f;
         unsigned ticker_speed      = (unsigned)(((float)TICKER_SPEED / speed_factor) + 0.5);
         unsigned ticker_slow_speed = (unsigned)(((float)TICKER_SLOW_SPEED / speed_factor) + 0.5);
 
-        cur_time   = cpu_features_get_time_usec() / 1000;
-        delta_time = old_time == 0 ? 0 : cur_time - old_time;
+        this->m_curTime   = this->m_clock() / 1000;
+        this->m_deltaTime = this->m_oldTime == 0 ? 0 : this->m_curTime - this->m_oldTime;
 
-        old_time = cur_time;
+        this->m_oldTime = this->m_curTime;
 
-        highlight_gradient_x = (cos((double)cur_time / HIGHLIGHT_SPEED / 3.0) + 1.0) / 2.0;
-        highlight_gradient_y = (sin((double)cur_time / HIGHLIGHT_SPEED / 3.0) + 1.0) / 2.0;
-        highlight_color      = (sin((double)cur_time / HIGHLIGHT_SPEED * 2.0) + 1.0) / 2.0;
+        this->m_highlightGradientX = (cos((double)this->m_curTime / HIGHLIGHT_SPEED / 3.0) + 1.0) / 2.0;
+        this->m_highlightGradientY = (sin((double)this->m_curTime / HIGHLIGHT_SPEED / 3.0) + 1.0) / 2.0;
+        this->m_highlightColor     = (sin((double)this->m_curTime / HIGHLIGHT_SPEED * 2.0) + 1.0) / 2.0;
 
-        if (((cur_time - last_clock_update) > 1000)
+        if (((this->m_curTime - this->m_lastClockUpdate) > 1000)
             && timedate_enable)
         {
-            animation_is_active = true;
-            last_clock_update   = cur_time;
+            this->m_animationIsActive = true;
+            this->m_lastClockUpdate   = this->m_curTime;
         }
 
-        if (ticker_is_active
-            && cur_time - last_ticker_update >= ticker_speed)
+        if (this->m_tickerIsActive
+            && this->m_curTime - this->m_lastTickerUpdate >= ticker_speed)
         {
-            ticker_idx++;
-            last_ticker_update = cur_time;
+            this->m_tickerIdx++;
+            this->m_lastTickerUpdate = this->m_curTime;
         }
 
-        if (ticker_is_active
-            && cur_time - last_ticker_slow_update >= ticker_slow_speed)
+        if (this->m_tickerIsActive
+            && this->m_curTime - this->m_lastTickerSlowUpdate >= ticker_slow_speed)
         {
-            ticker_slow_idx++;
-            last_ticker_slow_update = cur_time;
+            this->m_tickerSlowIdx++;
+            this->m_lastTickerSlowUpdate = this->m_curTime;
         }
     }
 
-    bool menu_animation_update(void)
+    /* Timer deadlines are on the engine clock; before the first
+     * update() there is no engine time yet, so read the clock */
+    int64_t AnimationEngine::timerNow()
     {
-        unsigned i;
+        return this->m_oldTime != 0 ? this->m_curTime : this->m_clock() / 1000;
+    }
 
-        menu_animation_update_time(false);
+    void AnimationEngine::fireTimers()
+    {
+        uint32_t clears = this->m_clears;
+        size_t i;
 
-        anim.in_update       = true;
-        anim.pending_deletes = false;
+        this->m_expiredTimers.clear();
+        this->m_timers.advance(this->m_curTime, this->m_expiredTimers);
 
-        for (i = 0; i < anim.list.size(); i++)
+        /* Nodes are released before their callback runs, so a
+         * callback may restart its own timer */
+        for (i = 0; i < this->m_expiredTimers.size(); i++)
         {
-            struct tween* tween = &anim.list[i];
-            tween->running_since += delta_time;
+            uint32_t id = this->m_expiredTimers[i];
+            menu_timer_payload payload;
 
-            *tween->subject = tween->easing(
-                tween->running_since,
-                tween->initial_value,
-                tween->target_value - tween->initial_value,
-                tween->duration);
+            if (this->m_timers.isCancelled(id))
+            {
+                this->m_timers.release(id);
+                continue;
+            }
+
+            payload = std::move(this->m_timers.get(id).payload);
+            this->m_timers.release(id);
+
+            if (payload.delayed)
+            {
+                this->push(&payload.entry);
+                continue;
+            }
+
+            this->m_timerHandles.erase(payload.timer);
+            *payload.timer = 1.0f;
+
+            if (payload.cb)
+                payload.cb(payload.userdata);
+
+            /* clear() released every node the rest of the batch
+             * refers to */
+            if (this->m_clears != clears)
+                break;
+        }
+    }
+
+    bool AnimationEngine::update()
+    {
+        size_t i, count;
+        uint32_t clears;
+
+        this->updateTime(false);
+
+        this->m_inUpdate       = true;
+        this->m_pendingDeletes = false;
+
+        /* Tweens pushed by callbacks land past `count`, this
+         * includes delayed tweens promoted by fireTimers() */
+        count  = this->m_hot.size();
+        clears = this->m_clears;
 
-            if (tween->tick)
-                tween->tick(tween->userdata);
+        this->fireTimers();
+
+        /* A timer callback that called clear() emptied the store;
+         * whatever it pushed since starts next frame */
+        if (this->m_clears != clears)
+            count = 0;
+
+        /* Advance every live tween and group them by easing type
+         * (counting sort) so each type is eased in batches */
+        {
+            size_t offsets[EASING_LAST + 1] = { 0 };
+            size_t type;
 
-            if (tween->running_since >= tween->duration)
+            for (i = 0; i < count; i++)
             {
-                *tween->subject = tween->target_value;
+                if (this->m_deleted[i])
+                    continue;
+
+                this->m_hot[i].running_since += this->m_deltaTime;
+                offsets[this->m_hot[i].easing + 1]++;
+            }
 
-                if (tween->cb)
-                    tween->cb(tween->userdata);
+            for (type = 0; type < EASING_LAST; type++)
+                offsets[type + 1] += offsets[type];
 
-                anim.list.erase(anim.list.begin() + i);
-                i--;
+            this->m_order.resize(offsets[EASING_LAST]);
+
+            for (i = 0; i < count; i++)
+            {
+                if (!this->m_deleted[i])
+                    this->m_order[offsets[this->m_hot[i].easing]++] = (uint32_t)i;
+            }
+
+            /* offsets[type] now holds the end of each group */
+            for (type = 0; type < EASING_LAST; type++)
+            {
+                size_t begin = type == 0 ? 0 : offsets[type - 1];
+
+                if (offsets[type] > begin)
+                    this->easeGroup((uint8_t)type, &this->m_order[begin], offsets[type] - begin);
             }
         }
 
-        if (anim.pending_deletes)
+        /* Callbacks fire in store order; finished tweens are only
+         * flagged here so callbacks may safely push or kill tweens.
+         * Tweens killed earlier in this frame are skipped.
+         * A callback that pushes may reallocate the cold array, so
+         * each callback is moved out while it runs; indices below
+         * `count` stay put until the compaction pass. */
+        for (i = 0; i < count; i++)
         {
-            for (i = 0; i < anim.list.size(); i++)
+            if (this->m_deleted[i])
+                continue;
+
+            if (this->m_cold[i].tick)
+            {
+                tween_cb tick = std::move(this->m_cold[i].tick);
+                tick(this->m_cold[i].userdata);
+
+                /* A callback that called clear() took tween i, and
+                 * every index up to `count`, with it */
+                if (this->m_clears != clears)
+                    break;
+
+                this->m_cold[i].tick = std::move(tick);
+            }
+
+            if (!this->m_deleted[i] && tween_is_finished(&this->m_hot[i]))
             {
-                struct tween* tween = &anim.list[i];
-                if (tween->deleted)
+                *this->m_hot[i].subject = this->m_hot[i].target_value;
+
+                if (this->m_cold[i].cb)
                 {
-                    anim.list.erase(anim.list.begin() + i);
-                    i--;
+                    tween_cb cb = std::move(this->m_cold[i].cb);
+                    cb(this->m_cold[i].userdata);
+
+                    if (this->m_clears != clears)
+                        break;
                 }
+
+                this->m_deleted[i]     = true;
+                this->m_pendingDeletes = true;
             }
-            anim.pending_deletes = false;
         }
 
-        if (anim.pending.size() > 0)
+        if (this->m_pendingDeletes)
         {
-            anim.list.insert(anim.list.begin(), anim.pending.begin(), anim.pending.end());
-            anim.pending.clear();
+            /* Single compaction pass, O(1) per removed tween */
+            for (i = 0; i < this->m_hot.size(); )
+            {
+                if (this->m_deleted[i])
+                    this->removeAt(i);
+                else
+                    i++;
+            }
+            this->m_pendingDeletes = false;
         }
 
-        anim.in_update      = false;
-        animation_is_active = anim.list.size() > 0;
+        this->m_inUpdate          = false;
+        this->m_animationIsActive = this->m_hot.size() > 0;
 
-        return animation_is_active;
+#if defined(EXUI_PROFILER)
+        Trace::counter("tweens", (int64_t)this->m_hot.size());
+        Trace::counter("timers", (int64_t)this->m_timers.size());
+#endif /* EXUI_PROFILER */
+
+        return this->m_animationIsActive;
     }
 
-    bool menu_animation_ticker(menu_animation_ctx_ticker_t* ticker)
+    bool AnimationEngine::ticker(menu_animation_ctx_ticker_t* ticker)
     {
         size_t str_len = utf8len(ticker->str);
 
@@ -797,91 +1130,284 @@ namespace eXUI
             }
         }
 
-        ticker_is_active = true;
+        this->m_tickerIsActive = true;
 
         return true;
     }
 
-    bool menu_animation_is_active(void)
+    /* Scrolls a retained Ticker using this engine's ticker index */
+    bool AnimationEngine::ticker(Ticker* ticker, size_t len, bool selected, enum menu_animation_ticker_type type)
     {
-        return animation_is_active || ticker_is_active;
+        if (!ticker->update(this->m_tickerIdx, len, selected, type))
+            return false;
+
+        this->m_tickerIsActive = true;
+
+        return true;
     }
 
-    bool menu_animation_kill_by_tag(menu_animation_ctx_tag* tag)
+    static void ticker_build_index(const std::string& str, std::vector<uint32_t>& offsets)
     {
-        unsigned i;
+        size_t i;
 
-        if (!tag || *tag == (uintptr_t)-1)
+        offsets.clear();
+
+        for (i = 0; i < str.size(); i++)
+        {
+            /* skip UTF-8 continuation bytes */
+            if (((uint8_t)str[i] & 0xC0) != 0x80)
+                offsets.push_back((uint32_t)i);
+        }
+
+        offsets.push_back((uint32_t)str.size());
+    }
+
+    Ticker::Ticker()
+        : m_spans(),
+        m_valid(false),
+        m_idx(0),
+        m_len(0),
+        m_selected(false),
+        m_type(TICKER_TYPE_BOUNCE),
+        m_scrolling(false)
+    {
+        ticker_build_index(this->m_text, this->m_textOffsets);
+        ticker_build_index(this->m_spacer, this->m_spacerOffsets);
+    }
+
+    Ticker::Ticker(const Ticker& other)
+        : Ticker()
+    {
+        *this = other;
+    }
+
+    Ticker::Ticker(Ticker&& other) noexcept
+        : Ticker()
+    {
+        *this = std::move(other);
+    }
+
+    Ticker& Ticker::operator=(const Ticker& other)
+    {
+        if (this == &other)
+            return *this;
+
+        this->m_text          = other.m_text;
+        this->m_spacer        = other.m_spacer;
+        this->m_textOffsets   = other.m_textOffsets;
+        this->m_spacerOffsets = other.m_spacerOffsets;
+        this->m_spans         = menu_animation_ticker_spans_t();
+        this->m_valid         = false;
+
+        return *this;
+    }
+
+    Ticker& Ticker::operator=(Ticker&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        this->m_text          = std::move(other.m_text);
+        this->m_spacer        = std::move(other.m_spacer);
+        this->m_textOffsets   = std::move(other.m_textOffsets);
+        this->m_spacerOffsets = std::move(other.m_spacerOffsets);
+        this->m_spans         = menu_animation_ticker_spans_t();
+        this->m_valid         = false;
+
+        /* Leaves other an empty ticker rather than one whose
+         * offsets no longer match its strings */
+        other.m_text.clear();
+        other.m_spacer.clear();
+        ticker_build_index(other.m_text, other.m_textOffsets);
+        ticker_build_index(other.m_spacer, other.m_spacerOffsets);
+        other.m_spans = menu_animation_ticker_spans_t();
+        other.m_valid = false;
+
+        return *this;
+    }
+
+    void Ticker::setText(std::string_view str, std::string_view spacer)
+    {
+        if (spacer.empty())
+            spacer = ticker_spacer_default;
+
+        if (this->m_textOffsets.size() > 0 && str == this->m_text && spacer == this->m_spacer)
+            return;
+
+        this->m_text   = str;
+        this->m_spacer = spacer;
+        ticker_build_index(this->m_text, this->m_textOffsets);
+        ticker_build_index(this->m_spacer, this->m_spacerOffsets);
+
+        this->m_valid = false;
+    }
+
+    std::string_view Ticker::textSlice(size_t offset, size_t width)
+    {
+        size_t begin = this->m_textOffsets[offset];
+        return std::string_view(this->m_text).substr(begin, this->m_textOffsets[offset + width] - begin);
+    }
+
+    std::string_view Ticker::spacerSlice(size_t offset, size_t width)
+    {
+        size_t begin = this->m_spacerOffsets[offset];
+        return std::string_view(this->m_spacer).substr(begin, this->m_spacerOffsets[offset + width] - begin);
+    }
+
+    /* Same layout as menu_animation_ticker(), returns whether
+     * the text is scrolling */
+    bool Ticker::update(uint64_t idx, size_t len, bool selected, enum menu_animation_ticker_type type)
+    {
+        size_t str_len = this->m_textOffsets.size() - 1;
+        menu_animation_ticker_spans_t* out = &this->m_spans;
+
+        if (this->m_valid && this->m_len == len && this->m_selected == selected
+            && this->m_type == type && (this->m_idx == idx || !this->m_scrolling))
+            return this->m_scrolling;
+
+        this->m_valid     = true;
+        this->m_idx       = idx;
+        this->m_len       = len;
+        this->m_selected  = selected;
+        this->m_type      = type;
+        this->m_scrolling = false;
+        out->count        = 0;
+
+        if (str_len <= len)
+        {
+            out->spans[out->count++] = this->m_text;
             return false;
+        }
 
-        for (i = 0; i < anim.list.size(); ++i)
+        if (!selected)
         {
-            struct tween* t = &anim.list[i];
-            if (t->tag != *tag)
-                continue;
+            out->spans[out->count++] = this->textSlice(0, len > 3 ? len - 3 : 0);
+            out->spans[out->count++] = "...";
+            return false;
+        }
 
-            if (anim.in_update)
+        switch (type)
+        {
+            case TICKER_TYPE_LOOP:
             {
-                t->deleted           = true;
-                anim.pending_deletes = true;
+                size_t offset1, offset2, offset3;
+                size_t width1, width2, width3;
+
+                menu_animation_ticker_loop(
+                    idx,
+                    len,
+                    str_len, this->m_spacerOffsets.size() - 1,
+                    &offset1, &width1,
+                    &offset2, &width2,
+                    &offset3, &width3);
+
+                if (width1 > 0)
+                    out->spans[out->count++] = this->textSlice(offset1, width1);
+
+                if (width2 > 0)
+                    out->spans[out->count++] = this->spacerSlice(offset2, width2);
+
+                if (width3 > 0)
+                    out->spans[out->count++] = this->textSlice(offset3, width3);
+
+                break;
             }
-            else
+            case TICKER_TYPE_BOUNCE:
+            default:
             {
-                anim.list.erase(anim.list.begin() + i);
-                --i;
+                size_t offset = 0;
+                size_t width  = str_len;
+
+                menu_animation_ticker_generic(
+                    idx,
+                    len,
+                    &offset,
+                    &width);
+
+                out->spans[out->count++] = this->textSlice(offset, width);
+
+                break;
             }
         }
 
+        this->m_scrolling = true;
+
         return true;
     }
 
-    void menu_animation_kill_by_subject(menu_animation_ctx_subject_t* subject)
+    const menu_animation_ticker_spans_t& Ticker::getSpans()
     {
-        unsigned i, j, killed = 0;
-        float** sub = (float**)subject->data;
+        return this->m_spans;
+    }
 
-        for (i = 0; i < anim.list.size() && killed < subject->count; ++i)
+    bool AnimationEngine::isActive()
+    {
+        return this->m_animationIsActive || this->m_tickerIsActive;
+    }
+
+    bool AnimationEngine::killByTag(menu_animation_ctx_tag* tag)
+    {
+        if (!tag || *tag == (uintptr_t)-1)
+            return false;
+
+        /* Removal outside of update() erases from the index, so
+         * always restart from the first remaining match */
+        while (true)
         {
-            struct tween* t = &anim.list[i];
+            auto range = this->m_tagIndex.equal_range(*tag);
+            auto it    = range.first;
+
+            while (it != range.second && this->m_deleted[this->m_slots[it->second].index])
+                ++it;
+
+            if (it == range.second)
+                break;
 
-            for (j = 0; j < subject->count; ++j)
+            this->killAt(this->m_slots[it->second].index);
+        }
+
+        return true;
+    }
+
+    void AnimationEngine::killBySubject(menu_animation_ctx_subject_t* subject)
+    {
+        size_t j;
+        float** sub = (float**)subject->data;
+
+        for (j = 0; j < subject->count; ++j)
+        {
+            while (true)
             {
-                if (t->subject != sub[j])
-                    continue;
+                auto range = this->m_subjectIndex.equal_range(sub[j]);
+                auto it    = range.first;
 
-                if (anim.in_update)
-                {
-                    t->deleted           = true;
-                    anim.pending_deletes = true;
-                }
-                else
-                {
-                    anim.list.erase(anim.list.begin() + i);
-                    --i;
-                }
+                while (it != range.second && this->m_deleted[this->m_slots[it->second].index])
+                    ++it;
 
-                killed++;
-                break;
+                if (it == range.second)
+                    break;
+
+                this->killAt(this->m_slots[it->second].index);
             }
         }
     }
 
-    float menu_animation_get_delta_time(void)
+    float AnimationEngine::getDeltaTime()
     {
-        return delta_time;
+        return this->m_deltaTime;
     }
 
-    bool menu_animation_ctl(enum menu_animation_ctl_state state, void* data)
+    bool AnimationEngine::ctl(enum menu_animation_ctl_state state, void* data)
     {
         switch (state)
         {
             case MENU_ANIMATION_CTL_CLEAR_ACTIVE:
-                animation_is_active = false;
-                ticker_is_active    = false;
+                this->m_animationIsActive = false;
+                this->m_tickerIsActive    = false;
                 break;
             case MENU_ANIMATION_CTL_SET_ACTIVE:
-                animation_is_active = true;
-                ticker_is_active    = true;
+                this->m_animationIsActive = true;
+                this->m_tickerIsActive    = true;
                 break;
             case MENU_ANIMATION_CTL_NONE:
             default:
@@ -891,41 +1417,172 @@ namespace eXUI
         return true;
     }
 
-    void menu_timer_start(menu_timer_t* timer, menu_timer_ctx_entry_t* timer_entry)
+    /* Timers with a tick callback need per-frame work anyway and
+     * stay linear tweens animating *timer from 0 to 1. The others
+     * go to the timer wheel: *timer reads 0 until the timer fires,
+     * then 1. */
+    void AnimationEngine::timerStart(menu_timer_t* timer, menu_timer_ctx_entry_t* timer_entry)
+    {
+        this->timerKill(timer);
+
+        *timer = 0.0f;
+
+        if (timer_entry->tick)
+        {
+            menu_animation_ctx_entry_t entry;
+
+            entry.easing_enum  = EASING_LINEAR;
+            entry.tag          = (uintptr_t)timer;
+            entry.duration     = timer_entry->duration;
+            entry.target_value = 1.0f;
+            entry.subject      = timer;
+            entry.cb           = timer_entry->cb;
+            entry.tick         = timer_entry->tick;
+            entry.userdata     = timer_entry->userdata;
+
+            this->push(&entry);
+        }
+        else
+        {
+            uint32_t id = this->m_timers.allocate();
+            menu_timer_payload& payload = this->m_timers.get(id).payload;
+
+            payload.timer    = timer;
+            payload.cb       = timer_entry->cb;
+            payload.userdata = timer_entry->userdata;
+            payload.delayed  = false;
+
+            this->m_timers.start(this->timerNow());
+            this->m_timerHandles[timer] = this->m_timers.schedule(id,
+                this->timerNow() + (int64_t)timer_entry->duration);
+        }
+    }
+
+    void AnimationEngine::timerKill(menu_timer_t* timer)
     {
-        menu_animation_ctx_entry_t entry;
         menu_animation_ctx_tag tag = (uintptr_t)timer;
+        auto it = this->m_timerHandles.find(timer);
 
-        menu_timer_kill(timer);
+        if (it != this->m_timerHandles.end())
+        {
+            this->m_timers.cancel(it->second);
+            this->m_timerHandles.erase(it);
+        }
 
-        *timer = 0.0f;
+        this->killByTag(&tag);
+    }
+
+    uint64_t AnimationEngine::getTickerIdx()
+    {
+        return this->m_tickerIdx;
+    }
+
+    uint64_t AnimationEngine::getTickerSlowIdx()
+    {
+        return this->m_tickerSlowIdx;
+    }
+
+    easing_cb menu_animation_get_easing(enum menu_animation_easing_type type)
+    {
+        if ((unsigned)type >= EASING_LAST)
+            return NULL;
+
+        return easing_funcs[type];
+    }
+
+    void menu_animation_init(void)
+    {
+        // Nothing to do
+    }
+
+    void menu_animation_free(void)
+    {
+        AnimationEngine::getDefault()->clear();
+    }
+
+    void menu_animation_push_delayed(unsigned delay, menu_animation_ctx_entry_t* entry)
+    {
+        AnimationEngine::getDefault()->pushDelayed(delay, entry);
+    }
 
-        entry.easing_enum  = EASING_LINEAR;
-        entry.tag          = tag;
-        entry.duration     = timer_entry->duration;
-        entry.target_value = 1.0f;
-        entry.subject      = timer;
-        entry.cb           = timer_entry->cb;
-        entry.tick         = timer_entry->tick;
-        entry.userdata     = timer_entry->userdata;
+    menu_animation_handle_t menu_animation_push(menu_animation_ctx_entry_t* entry)
+    {
+        return AnimationEngine::getDefault()->push(entry);
+    }
 
-        menu_animation_push(&entry);
+    bool menu_animation_kill(menu_animation_handle_t handle)
+    {
+        return AnimationEngine::getDefault()->kill(handle);
+    }
+
+    bool menu_animation_retarget(menu_animation_handle_t handle, float target_value, float duration)
+    {
+        return AnimationEngine::getDefault()->retarget(handle, target_value, duration);
+    }
+
+    bool menu_animation_get_progress(menu_animation_handle_t handle, float* progress)
+    {
+        return AnimationEngine::getDefault()->getProgress(handle, progress);
+    }
+
+    void menu_animation_get_highlight(float* gradient_x, float* gradient_y, float* color)
+    {
+        AnimationEngine::getDefault()->getHighlight(gradient_x, gradient_y, color);
+    }
+
+    bool menu_animation_update(void)
+    {
+        return AnimationEngine::getDefault()->update();
+    }
+
+    bool menu_animation_ticker(menu_animation_ctx_ticker_t* ticker)
+    {
+        return AnimationEngine::getDefault()->ticker(ticker);
+    }
+
+    bool menu_animation_is_active(void)
+    {
+        return AnimationEngine::getDefault()->isActive();
+    }
+
+    bool menu_animation_kill_by_tag(menu_animation_ctx_tag* tag)
+    {
+        return AnimationEngine::getDefault()->killByTag(tag);
+    }
+
+    void menu_animation_kill_by_subject(menu_animation_ctx_subject_t* subject)
+    {
+        AnimationEngine::getDefault()->killBySubject(subject);
+    }
+
+    float menu_animation_get_delta_time(void)
+    {
+        return AnimationEngine::getDefault()->getDeltaTime();
+    }
+
+    bool menu_animation_ctl(enum menu_animation_ctl_state state, void* data)
+    {
+        return AnimationEngine::getDefault()->ctl(state, data);
+    }
+
+    void menu_timer_start(menu_timer_t* timer, menu_timer_ctx_entry_t* timer_entry)
+    {
+        AnimationEngine::getDefault()->timerStart(timer, timer_entry);
     }
 
     void menu_timer_kill(menu_timer_t* timer)
     {
-        menu_animation_ctx_tag tag = (uintptr_t)timer;
-        menu_animation_kill_by_tag(&tag);
+        AnimationEngine::getDefault()->timerKill(timer);
     }
 
     uint64_t menu_animation_get_ticker_idx(void)
     {
-        return ticker_idx;
+        return AnimationEngine::getDefault()->getTickerIdx();
     }
 
     uint64_t menu_animation_get_ticker_slow_idx(void)
     {
-        return ticker_slow_idx;
+        return AnimationEngine::getDefault()->getTickerSlowIdx();
     }
 
-} // namespace eXUI
\ No newline at end of file
+} // namespace eXUI
@@ -1,5 +1,10 @@
 #include "eXUI/application.hpp"
 #include "eXUI/logger.hpp"
+#include "eXUI/memory_telemetry.hpp"
+#include "eXUI/profiler.hpp"
+#include "eXUI/trace.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <unistd.h>
 #include <arpa/inet.h>
@@ -26,14 +31,19 @@ namespace eXUI
 {
     void OutputDkDebug(void* userData, const char* context, DkResult result, const char* message)
     {
-        Logger::debug("Context: {}", context);
-        Logger::debug("Result: {}", result);
-        Logger::debug("Message: {}", message);
+        EXUI_LOG_DEBUG("Context: {}", context);
+        EXUI_LOG_DEBUG("Result: {}", result);
+        EXUI_LOG_DEBUG("Message: {}", message);
     }
 
-    DkApplication::DkApplication()
+    DkApplication::DkApplication(const DkApplicationConfig& config)
+        : m_config(config), m_pool_data("data"), m_pool_framebuffers("framebuffers"), m_framebufferBytes(0), m_idleFrames(0),
+          m_numFramebuffers(2), m_pendingFramebuffers(2), m_swapInterval(1), m_waitIdle(true), m_swapchainChanged(false)
     {
         Logger::setLogLevel(LogLevel::DEBUG);
+#if defined(EXUI_PROFILER)
+        Trace::setThreadName("main");
+#endif /* EXUI_PROFILER */
 
         Result res;
 
@@ -45,30 +55,62 @@ namespace eXUI
 
 #if defined(DEBUG_NXLINK)
         nxlinkSocket = nxlinkStdio();
-        Logger::debug("nxlink host is {}", inet_ntoa(__nxlink_host));
+#endif /* DEBUG_NXLINK */
+
+        // Keeps stdout (possibly the nxlink socket) off the render thread
+        Logger::startAsync(LogOverflow::DROP);
+
+#if defined(DEBUG_NXLINK)
+        // Log batches go straight to the socket, one send per TX buffer
+        if (nxlinkSocket != -1)
+        {
+            this->m_nxlinkSink.emplace(nxlinkSocket, socket_config.tcp_tx_buf_size);
+            Logger::addSink(&*this->m_nxlinkSink);
+        }
+#endif /* DEBUG_NXLINK */
+
+#if defined(DEBUG_NXLINK)
+        EXUI_LOG_DEBUG("nxlink host is {}", inet_ntoa(__nxlink_host));
 #endif /* DEBUG_NXLINK */
 
         this->m_device = dk::DeviceMaker{}.setCbDebug(OutputDkDebug).create();
         this->m_queue = dk::QueueMaker{this->m_device}.setFlags(DkQueueFlags_Graphics).create();
 
-        this->m_pool_images.emplace(this->m_device, DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image, 16*1024*1024);
-        this->m_pool_code.emplace(this->m_device, DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached | DkMemBlockFlags_Code, 128*1024);
-        this->m_pool_data.emplace(this->m_device, DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached, 1*1024*1024);
+        // The renderer allocates from the images and code pools directly,
+        // out of sight of the telemetry, so they get no rows of their own
+        this->m_pool_images.emplace(this->m_device, DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image, this->m_config.imagePoolSize);
+        this->m_pool_code.emplace(this->m_device, DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached | DkMemBlockFlags_Code, this->m_config.codePoolSize);
+        this->m_pool_data.create(this->m_device, DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached, this->m_config.dataPoolSize);
 
         this->m_cmdbuf = dk::CmdBufMaker{this->m_device}.create();
-        CMemPool::Handle cmdmem = this->m_pool_data->allocate(StaticCmdSize);
-        this->m_cmdbuf.addMemory(cmdmem.getMemBlock(), cmdmem.getOffset(), cmdmem.getSize());
+        this->m_cmdbuf_mem = this->m_pool_data.allocate(StaticCmdSize);
+
+        this->m_frame_cmdbuf = dk::CmdBufMaker{this->m_device}.create();
+        this->m_frame_cmdmem = this->m_pool_data.allocate(MaxFramebuffers * FrameCmdSize);
 
         this->createFramebufferResources();
-        this->m_renderer.emplace(FramebufferWidth, FramebufferHeight, this->m_device, this->m_queue, *this->m_pool_images, *this->m_pool_code, *this->m_pool_data);
-        this->m_uiState.emplace(&*this->m_renderer, FramebufferWidth, FramebufferHeight);
+        this->m_renderer.emplace(FramebufferWidth, FramebufferHeight, this->m_device, this->m_queue, *this->m_pool_images, *this->m_pool_code, this->m_pool_data.get());
+        this->m_uiState.emplace(&*this->m_renderer, UIWidth, UIHeight);
+        this->m_uiState->setFramePacer(&this->m_pacer);
     }
 
     DkApplication::~DkApplication()
     {
+        // Flushes a capture still running at exit
+        Trace::stop();
         this->destroyFramebufferResources();
+        this->m_pool_data.free(this->m_frame_cmdmem);
+        this->m_pool_data.free(this->m_cmdbuf_mem);
         this->m_renderer.reset();
 
+        // Drains pending lines while stdout is still connected
+        Logger::stopAsync();
+
+#if defined(DEBUG_NXLINK)
+        if (this->m_nxlinkSink)
+            Logger::removeSink(&*this->m_nxlinkSink);
+#endif /* DEBUG_NXLINK */
+
 #if defined(DEBUG_NXLINK)
         if (nxlinkSocket != -1)
         {
@@ -82,6 +124,15 @@ namespace eXUI
 
     void DkApplication::createFramebufferResources()
     {
+        // Every caller has freed the old images by now, so a depth
+        // requested by setSwapchain() can take effect
+        this->m_numFramebuffers = this->m_pendingFramebuffers;
+        this->m_swapchainChanged = false;
+
+        // The static lists are re-recorded from the start of their memory
+        this->m_cmdbuf.clear();
+        this->m_cmdbuf.addMemory(this->m_cmdbuf_mem.getMemBlock(), this->m_cmdbuf_mem.getOffset(), this->m_cmdbuf_mem.getSize());
+
         dk::ImageLayout layout_depthbuffer;
         dk::ImageLayoutMaker{this->m_device}
             .setFlags(DkImageFlags_UsageRender | DkImageFlags_HwCompression)
@@ -89,9 +140,6 @@ namespace eXUI
             .setDimensions(FramebufferWidth, FramebufferHeight)
             .initialize(layout_depthbuffer);
 
-        this->m_depthBuffer_mem = this->m_pool_images->allocate(layout_depthbuffer.getSize(), layout_depthbuffer.getAlignment());
-        this->m_depthBuffer.initialize(layout_depthbuffer, this->m_depthBuffer_mem.getMemBlock(), this->m_depthBuffer_mem.getOffset());
-
         dk::ImageLayout layout_framebuffer;
         dk::ImageLayoutMaker{this->m_device}
             .setFlags(DkImageFlags_UsageRender | DkImageFlags_UsagePresent | DkImageFlags_HwCompression)
@@ -99,12 +147,24 @@ namespace eXUI
             .setDimensions(FramebufferWidth, FramebufferHeight)
             .initialize(layout_framebuffer);
 
-        std::array<DkImage const*, NumFramebuffers> fb_array;
+        std::array<DkImage const*, MaxFramebuffers> fb_array;
         uint64_t fb_size  = layout_framebuffer.getSize();
         uint32_t fb_align = layout_framebuffer.getAlignment();
-        for (unsigned i = 0; i < NumFramebuffers; i ++)
+
+        // One block holding the depth buffer and every back buffer
+        uint64_t needed = (layout_depthbuffer.getSize() + fb_align - 1) & ~(uint64_t)(fb_align - 1);
+        needed += this->m_numFramebuffers * ((fb_size + fb_align - 1) & ~(uint64_t)(fb_align - 1));
+        this->m_framebufferBytes = (uint32_t)((needed + DK_MEMBLOCK_ALIGNMENT - 1) & ~(uint64_t)(DK_MEMBLOCK_ALIGNMENT - 1));
+        if (!this->m_pool_framebuffers.isCreated())
+            this->m_pool_framebuffers.create(this->m_device, DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image,
+                std::max(this->m_config.framebufferPoolSize, this->m_framebufferBytes));
+
+        this->m_depthBuffer_mem = this->m_pool_framebuffers.allocate(layout_depthbuffer.getSize(), layout_depthbuffer.getAlignment());
+        this->m_depthBuffer.initialize(layout_depthbuffer, this->m_depthBuffer_mem.getMemBlock(), this->m_depthBuffer_mem.getOffset());
+
+        for (unsigned i = 0; i < this->m_numFramebuffers; i ++)
         {
-            this->m_framebuffers_mem[i] = this->m_pool_images->allocate(fb_size, fb_align);
+            this->m_framebuffers_mem[i] = this->m_pool_framebuffers.allocate(fb_size, fb_align);
             this->m_framebuffers[i].initialize(layout_framebuffer, this->m_framebuffers_mem[i].getMemBlock(), this->m_framebuffers_mem[i].getOffset());
             dk::ImageView colorTarget{ this->m_framebuffers[i] }, depthTarget{ this->m_depthBuffer };
             this->m_cmdbuf.bindRenderTargets(&colorTarget, &depthTarget);
@@ -112,8 +172,16 @@ namespace eXUI
             fb_array[i] = &this->m_framebuffers[i];
         }
 
-        this->m_swapchain = dk::SwapchainMaker{this->m_device, nwindowGetDefault(), fb_array}.create();
+        this->m_swapchain = dk::SwapchainMaker{this->m_device, nwindowGetDefault(), fb_array.data(), this->m_numFramebuffers}.create();
+        this->m_swapchain.setSwapInterval(this->m_swapInterval);
+        this->m_pacer.setVsyncPeriod(this->m_swapInterval * IdleFrameInterval);
+        this->m_governor.setBudget(this->m_swapInterval * IdleFrameInterval);
+        // The crop belongs to the window and outlives the swapchain
+        nwindowSetCrop(nwindowGetDefault(), 0, 0, RenderWidth, RenderHeight);
         this->recordStaticCommands();
+
+        if (this->m_uiState)
+            this->m_uiState->invalidateBuffers();
     }
 
     void DkApplication::destroyFramebufferResources()
@@ -122,9 +190,9 @@ namespace eXUI
         this->m_queue.waitIdle();
         this->m_cmdbuf.clear();
         this->m_swapchain.destroy();
-        for (unsigned i = 0; i < NumFramebuffers; i ++)
-            this->m_framebuffers_mem[i].destroy();
-        this->m_depthBuffer_mem.destroy();
+        for (unsigned i = 0; i < this->m_numFramebuffers; i ++)
+            this->m_pool_framebuffers.free(this->m_framebuffers_mem[i]);
+        this->m_pool_framebuffers.free(this->m_depthBuffer_mem);
     }
 
     void DkApplication::recordStaticCommands()
@@ -134,12 +202,8 @@ namespace eXUI
         dk::ColorWriteState colorWriteState;
         dk::BlendState blendState;
 
-        this->m_cmdbuf.setViewports(0, { { 0.0f, 0.0f, static_cast<float>(FramebufferWidth), static_cast<float>(FramebufferHeight), 0.0f, 1.0f } });
-        this->m_cmdbuf.setScissors(0, { { 0, 0, FramebufferWidth, FramebufferHeight } });
-
-        this->m_cmdbuf.clearColor(0, DkColorMask_RGBA, 0.2f, 0.3f, 0.3f, 1.0f);
-        this->m_cmdbuf.clearDepthStencil(true, 1.0f, 0xFF, 0);
-
+        // Viewport, scissor and clears follow the render size and are
+        // recorded per frame by submitClear()
         this->m_cmdbuf.bindRasterizerState(rasterizerState);
         this->m_cmdbuf.bindColorState(colorState);
         this->m_cmdbuf.bindColorWriteState(colorWriteState);
@@ -147,24 +211,237 @@ namespace eXUI
         this->m_render_cmdlist = this->m_cmdbuf.finishList();
     }
 
+    // Reallocates the framebuffers and depth buffer at the output size,
+    // so docked mode renders natively instead of upscaling 720p
+    void DkApplication::onFramebufferDimensionChange()
+    {
+        if (FramebufferWidth == OutputWidth && FramebufferHeight == OutputHeight)
+            return;
+
+        EXUI_LOG_INFO("Framebuffer {}x{} -> {}x{}", FramebufferWidth, FramebufferHeight, OutputWidth, OutputHeight);
+
+        // Frees the old images first so the pool can reuse their space
+        this->destroyFramebufferResources();
+        FramebufferWidth = OutputWidth;
+        FramebufferHeight = OutputHeight;
+        this->createFramebufferResources();
+
+        this->m_governor.setOutput(FramebufferWidth, FramebufferHeight);
+        this->setRenderSize(FramebufferWidth, FramebufferHeight);
+    }
+
+    // The framebuffer pool keeps the blocks it grew for a larger output
+    // or deeper swapchain; it is rebuilt only if those or fragmentation
+    // waste space. Every image in it is reallocated, so the back buffers
+    // lose their contents and are redrawn in full.
+    bool DkApplication::compactFramebufferPool()
+    {
+        GpuPoolStats stats = this->m_pool_framebuffers.getStats();
+        uint32_t blockSize = std::max(this->m_config.framebufferPoolSize, this->m_framebufferBytes);
+
+        if (stats.blocks <= 1 && stats.reserved <= blockSize &&
+            stats.fragmentation <= this->m_config.compactFragmentation)
+            return false;
+
+        EXUI_LOG_INFO("Compacting framebuffer pool: {} blocks, {} bytes, {:.0f}% fragmented -> {} bytes",
+            stats.blocks, stats.reserved, stats.fragmentation * 100.0f, blockSize);
+
+        this->destroyFramebufferResources();
+        this->m_pool_framebuffers.compact(blockSize);
+        this->createFramebufferResources();
+        return true;
+    }
+
+    // Renders into the top left width x height of the framebuffers and
+    // has the compositor crop and scale that to the screen
+    void DkApplication::setRenderSize(uint32_t width, uint32_t height)
+    {
+        RenderWidth = width;
+        RenderHeight = height;
+
+        nwindowSetCrop(nwindowGetDefault(), 0, 0, RenderWidth, RenderHeight);
+        this->m_renderer->UpdateViewBounds(RenderWidth, RenderHeight);
+        if (this->m_uiState)
+            this->m_uiState->invalidateBuffers();
+    }
+
+    // Clears only the damaged rects, the rest of the back buffer still
+    // holds what it showed last time and is not redrawn
+    void DkApplication::submitClear(int slot, const DamageRegion& damage)
+    {
+        // The commands this slot's memory held last time must have run
+        this->m_frame_fences[slot].wait();
+        this->m_frame_cmdbuf.clear();
+        this->m_frame_cmdbuf.addMemory(this->m_frame_cmdmem.getMemBlock(), this->m_frame_cmdmem.getOffset() + slot * FrameCmdSize, FrameCmdSize);
+
+        this->m_frame_cmdbuf.setViewports(0, { { 0.0f, 0.0f, static_cast<float>(RenderWidth), static_cast<float>(RenderHeight), 0.0f, 1.0f } });
+
+        // UI units to render pixels, rounding outward
+        float sx = (float)RenderWidth / UIWidth, sy = (float)RenderHeight / UIHeight;
+        for (int i = 0; i < damage.count; i++)
+        {
+            const DamageRect& rect = damage.rects[i];
+            uint32_t x0 = (uint32_t)(rect.x * sx), y0 = (uint32_t)(rect.y * sy);
+            uint32_t x1 = std::min(RenderWidth, (uint32_t)ceilf((rect.x + rect.w) * sx));
+            uint32_t y1 = std::min(RenderHeight, (uint32_t)ceilf((rect.y + rect.h) * sy));
+
+            this->m_frame_cmdbuf.setScissors(0, { { x0, y0, x1 - x0, y1 - y0 } });
+            this->m_frame_cmdbuf.clearColor(0, DkColorMask_RGBA, 0.2f, 0.3f, 0.3f, 1.0f);
+            this->m_frame_cmdbuf.clearDepthStencil(true, 1.0f, 0xFF, 0);
+        }
+        this->m_frame_cmdbuf.setScissors(0, { { 0, 0, RenderWidth, RenderHeight } });
+        this->m_frame_cmdbuf.signalFence(this->m_frame_fences[slot]);
+
+        this->m_queue.submitCommands(this->m_frame_cmdbuf.finishList());
+    }
+
     void DkApplication::render(u64 ns)
     {
-        int slot = this->m_queue.acquireImage(this->m_swapchain);
+        EXUI_PROFILE_ZONE("DkApplication::render");
+        u64 acquired;
+        int slot;
+
+        {
+            EXUI_PROFILE_ZONE("acquireImage");
+            slot = this->m_queue.acquireImage(this->m_swapchain);
+        }
+        acquired = armGetSystemTick();
+        this->m_pacer.acquired(armTicksToNs(acquired));
+
+        const DamageRegion& damage = this->m_uiState->beginFrame(slot);
         this->m_queue.submitCommands(this->m_framebuffer_cmdlists[slot]);
         this->m_queue.submitCommands(this->m_render_cmdlist);
-        this->m_uiState->render(ns, OutputWidth, OutputHeight);
-        this->m_queue.presentImage(this->m_swapchain, slot);
+        this->submitClear(slot, damage);
+        this->m_uiState->render(ns, RenderWidth, RenderHeight);
+
+        {
+            EXUI_PROFILE_ZONE("presentImage");
+            this->m_queue.presentImage(this->m_swapchain, slot);
+        }
+        this->m_pacer.presented(armTicksToNs(armGetSystemTick()));
+
+        // Low latency: no frame is left queued when the next one samples
+        // input, at the cost of CPU and GPU no longer overlapping
+        if (this->m_waitIdle)
+        {
+            EXUI_PROFILE_ZONE("waitIdle");
+            this->m_queue.waitIdle();
+        }
+
+        // Busy time from the image being free to the frame being done
+        u64 work = armTicksToNs(armGetSystemTick() - acquired);
+        if (this->m_governor.update(work, this->m_pacer.getStats()))
+            this->setRenderSize(this->m_governor.getWidth(), this->m_governor.getHeight());
     }
 
     bool DkApplication::onFrame(u64 ns)
     {
+        // ns counts from the start of the app, the idle sleep below
+        // needs the absolute tick the frame began at
+        u64 start = armGetSystemTick();
+
+        // Closes the previous frame, whose onFrame zone has ended by now
+        EXUI_PROFILE_FRAME();
+        MemoryTelemetry::endFrame();
+        EXUI_PROFILE_ZONE("DkApplication::onFrame");
+
+        if (this->m_swapchainChanged)
+        {
+            this->destroyFramebufferResources();
+            this->createFramebufferResources();
+        }
+
         if (!this->m_uiState->onFrame(ns))
             return false;
 
-        this->render(ns);
+        if (this->m_uiState->isDirty())
+        {
+            this->m_idleFrames = 0;
+            this->render(ns);
+            return true;
+        }
+
+        // Nothing changed: keep showing the last presented image and
+        // sleep out the rest of the frame instead of spinning
+        EXUI_PROFILE_ZONE("idle");
+        this->m_pacer.idle();
+
+        // Once per idle stretch, while a full redraw goes unnoticed
+        if (++this->m_idleFrames == this->m_config.compactIdleFrames)
+            this->compactFramebufferPool();
+
+        u64 elapsed = armTicksToNs(armGetSystemTick() - start);
+        if (elapsed < IdleFrameInterval)
+            svcSleepThread(IdleFrameInterval - elapsed);
+
         return true;
     }
 
+    FramePacer* DkApplication::getFramePacer()
+    {
+        return &this->m_pacer;
+    }
+
+    ResolutionGovernor* DkApplication::getResolutionGovernor()
+    {
+        return &this->m_governor;
+    }
+
+    GpuPoolStats DkApplication::getFramebufferPoolStats()
+    {
+        return this->m_pool_framebuffers.getStats();
+    }
+
+    void DkApplication::setPresentMode(PresentMode mode)
+    {
+        switch (mode)
+        {
+        case PresentMode::THROUGHPUT:
+            this->setSwapchain(3, 1, false);
+            break;
+
+        case PresentMode::LOW_LATENCY:
+        default:
+            this->setSwapchain(2, 1, true);
+            break;
+        }
+    }
+
+    // depth is 2 or 3 images; a swap interval of 2 presents at 30 Hz
+    void DkApplication::setSwapchain(unsigned depth, uint32_t swapInterval, bool waitIdle)
+    {
+        depth = std::clamp(depth, 2u, MaxFramebuffers);
+        swapInterval = std::max(swapInterval, 1u);
+
+        this->m_waitIdle = waitIdle;
+
+        if (depth != this->m_pendingFramebuffers)
+        {
+            // Rebuilt between frames by onFrame(); m_numFramebuffers keeps
+            // the old depth until the old images are freed
+            this->m_pendingFramebuffers = depth;
+            this->m_swapInterval = swapInterval;
+            this->m_swapchainChanged = true;
+        }
+        else if (swapInterval != this->m_swapInterval)
+        {
+            this->m_swapInterval = swapInterval;
+            this->m_swapchain.setSwapInterval(swapInterval);
+            this->m_pacer.setVsyncPeriod(swapInterval * IdleFrameInterval);
+            this->m_governor.setBudget(swapInterval * IdleFrameInterval);
+        }
+    }
+
+    unsigned DkApplication::getSwapchainDepth()
+    {
+        return this->m_pendingFramebuffers;
+    }
+
+    uint32_t DkApplication::getSwapInterval()
+    {
+        return this->m_swapInterval;
+    }
+
     void DkApplication::onOperationMode(AppletOperationMode opMode)
     {
         switch (opMode)
@@ -180,5 +457,11 @@ namespace eXUI
             OutputWidth = 1280;
             break;
         }
+
+        if (this->m_swapchain)
+            this->onFramebufferDimensionChange();
+
+        if (this->m_uiState)
+            this->m_uiState->invalidate();
     }
 } // namespace eXUI
\ No newline at end of file
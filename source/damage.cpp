@@ -0,0 +1,202 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/damage.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace eXUI
+{
+    static DamageRect damage_union(const DamageRect& a, const DamageRect& b)
+    {
+        int x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+        int x1 = std::max(a.x + a.w, b.x + b.w), y1 = std::max(a.y + a.h, b.y + b.h);
+
+        return { x0, y0, x1 - x0, y1 - y0 };
+    }
+
+    // Touching rects count too, merging them costs nothing
+    static bool damage_touches(const DamageRect& a, const DamageRect& b)
+    {
+        return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+    }
+
+    static int64_t damage_area(const DamageRect& rect)
+    {
+        return (int64_t)rect.w * rect.h;
+    }
+
+    DamageTracker::DamageTracker(int width, int height)
+    {
+        this->reset(width, height);
+    }
+
+    void DamageTracker::reset(int width, int height)
+    {
+        unsigned i;
+
+        this->m_width = width;
+        this->m_height = height;
+        this->m_frame = 0;
+        this->m_current.full = false;
+        this->m_current.count = 0;
+        this->m_overdraw.full = false;
+        this->m_overdraw.count = 0;
+        this->m_reported.full = false;
+        this->m_reported.count = 0;
+
+        for (i = 0; i < DAMAGE_HISTORY; i++)
+            this->m_slotFrame[i] = 0;
+
+        this->addFull();
+    }
+
+    void DamageTracker::clip(DamageRect& rect, float x, float y, float w, float h)
+    {
+        /* Outward to whole pixels, so antialiased edges are covered */
+        int x0 = std::max(0, (int)floorf(x)), y0 = std::max(0, (int)floorf(y));
+        int x1 = std::min(this->m_width, (int)ceilf(x + w)), y1 = std::min(this->m_height, (int)ceilf(y + h));
+
+        rect = { x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0) };
+    }
+
+    void DamageTracker::setFull(DamageRegion& region)
+    {
+        region.full = true;
+        region.count = 1;
+        region.rects[0] = { 0, 0, this->m_width, this->m_height };
+    }
+
+    void DamageTracker::merge(DamageRegion& region, DamageRect rect)
+    {
+        int64_t area = 0, growth, best;
+        int i, pick;
+
+        if (region.full || rect.w <= 0 || rect.h <= 0)
+            return;
+
+        /* Folds in every rect the new one touches, then, while the region
+         * is at capacity, whichever rect grows the least when merged. Each
+         * merge can make the result touch others, hence the restarts. */
+        for (i = 0; i < region.count;)
+        {
+            if (damage_touches(rect, region.rects[i]))
+            {
+                rect = damage_union(rect, region.rects[i]);
+                region.rects[i] = region.rects[--region.count];
+                i = 0;
+            }
+            else
+                i++;
+
+            if (i == region.count && region.count == DAMAGE_MAX_RECTS)
+            {
+                best = INT64_MAX;
+                pick = 0;
+
+                for (i = 0; i < region.count; i++)
+                {
+                    growth = damage_area(damage_union(rect, region.rects[i])) - damage_area(region.rects[i]);
+                    if (growth < best)
+                    {
+                        best = growth;
+                        pick = i;
+                    }
+                }
+
+                rect = damage_union(rect, region.rects[pick]);
+                region.rects[pick] = region.rects[--region.count];
+                i = 0;
+            }
+        }
+
+        region.rects[region.count++] = rect;
+
+        for (i = 0; i < region.count; i++)
+            area += damage_area(region.rects[i]);
+
+        if (area > DAMAGE_FULL_RATIO * this->m_width * this->m_height)
+            this->setFull(region);
+    }
+
+    void DamageTracker::add(float x, float y, float w, float h)
+    {
+        DamageRect rect;
+
+        this->clip(rect, x, y, w, h);
+        this->merge(this->m_current, rect);
+    }
+
+    void DamageTracker::addFull()
+    {
+        this->setFull(this->m_current);
+    }
+
+    void DamageTracker::addOverdraw(float x, float y, float w, float h)
+    {
+        DamageRect rect;
+
+        this->clip(rect, x, y, w, h);
+        this->merge(this->m_overdraw, rect);
+    }
+
+    bool DamageTracker::isEmpty()
+    {
+        return this->m_current.count == 0 && this->m_overdraw.count == 0;
+    }
+
+    const DamageRegion& DamageTracker::resolve(unsigned slot)
+    {
+        DamageRegion& frame = this->m_history[++this->m_frame % DAMAGE_HISTORY];
+        uint64_t last = this->m_slotFrame[slot % DAMAGE_HISTORY];
+        uint64_t f;
+        int i;
+
+        this->m_reported = this->m_current;
+        frame = this->m_current;
+        for (i = 0; i < this->m_overdraw.count && !frame.full; i++)
+            this->merge(frame, this->m_overdraw.rects[i]);
+
+        this->m_current.full = false;
+        this->m_current.count = 0;
+        this->m_overdraw.full = false;
+        this->m_overdraw.count = 0;
+
+        /* The buffer shows frame `last`, it needs every frame after it */
+        if (last == 0 || this->m_frame - last > DAMAGE_HISTORY)
+            this->setFull(this->m_region);
+        else
+        {
+            this->m_region = frame;
+            for (f = last + 1; f < this->m_frame && !this->m_region.full; f++)
+            {
+                const DamageRegion& older = this->m_history[f % DAMAGE_HISTORY];
+                for (i = 0; i < older.count && !this->m_region.full; i++)
+                    this->merge(this->m_region, older.rects[i]);
+            }
+        }
+
+        this->m_slotFrame[slot % DAMAGE_HISTORY] = this->m_frame;
+        return this->m_region;
+    }
+
+    const DamageRegion& DamageTracker::getFrameDamage()
+    {
+        return this->m_reported;
+    }
+} // namespace eXUI
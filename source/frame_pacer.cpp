@@ -0,0 +1,115 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/frame_pacer.hpp"
+#include "eXUI/trace.hpp"
+#include <cstring>
+
+namespace eXUI
+{
+    FramePacer::FramePacer(u64 vsyncPeriod)
+        : m_vsyncPeriod(vsyncPeriod),
+        m_lastAcquire(0),
+        m_stats(),
+        m_graph(RenderStyle::PACING, "Frame Pacing")
+    {
+    }
+
+    void FramePacer::acquired(u64 ns)
+    {
+        u64 interval, vsyncs, boundary, deviation;
+        u64 bucket;
+
+        if (!this->m_lastAcquire)
+        {
+            this->m_lastAcquire = ns;
+            return;
+        }
+
+        interval            = ns - this->m_lastAcquire;
+        this->m_lastAcquire = ns;
+
+        // Whole vsyncs the frame stayed on screen, at least one
+        vsyncs = (interval + this->m_vsyncPeriod / 2) / this->m_vsyncPeriod;
+        if (vsyncs < 1)
+            vsyncs = 1;
+
+        boundary  = vsyncs * this->m_vsyncPeriod;
+        deviation = interval > boundary ? interval - boundary : boundary - interval;
+        bucket    = deviation / FRAME_PACER_JITTER_STEP;
+        if (bucket >= FRAME_PACER_JITTER_BUCKETS)
+            bucket = FRAME_PACER_JITTER_BUCKETS - 1;
+
+        this->m_stats.frames++;
+        this->m_stats.lastInterval = interval;
+        this->m_stats.jitter[bucket]++;
+
+        if (vsyncs > 1)
+        {
+            this->m_stats.missedFrames++;
+            this->m_stats.missedVsyncs += vsyncs - 1;
+
+            if (++this->m_stats.streak == 2)
+                this->m_stats.bursts++;
+            if (this->m_stats.streak > this->m_stats.longestStreak)
+                this->m_stats.longestStreak = this->m_stats.streak;
+        }
+        else
+            this->m_stats.streak = 0;
+
+        this->m_graph.update(interval / 1000000000.0f);
+
+#if defined(EXUI_PROFILER)
+        Trace::counter("missed vsyncs", (int64_t)(vsyncs - 1));
+#endif /* EXUI_PROFILER */
+    }
+
+    void FramePacer::presented(u64 ns)
+    {
+        if (this->m_lastAcquire)
+            this->m_stats.lastLatency = ns - this->m_lastAcquire;
+    }
+
+    void FramePacer::idle()
+    {
+        this->m_lastAcquire  = 0;
+        this->m_stats.streak = 0;
+    }
+
+    void FramePacer::reset()
+    {
+        memset(&this->m_stats, 0, sizeof(this->m_stats));
+        this->m_lastAcquire = 0;
+    }
+
+    void FramePacer::setVsyncPeriod(u64 vsyncPeriod)
+    {
+        this->m_vsyncPeriod = vsyncPeriod;
+        this->reset();
+    }
+
+    const FramePacingStats& FramePacer::getStats()
+    {
+        return this->m_stats;
+    }
+
+    PerfGraph* FramePacer::getGraph()
+    {
+        return &this->m_graph;
+    }
+} // namespace eXUI
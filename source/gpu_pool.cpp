@@ -0,0 +1,165 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/gpu_pool.hpp"
+#include "eXUI/logger.hpp"
+#include "eXUI/memory_telemetry.hpp"
+#include <algorithm>
+
+namespace eXUI
+{
+    GpuPool::GpuPool(const char* name)
+        : m_name(name), m_device(nullptr), m_flags(0), m_blockSize(0), m_telemetry(-1)
+    {
+    }
+
+    void GpuPool::create(DkDevice device, uint32_t flags, uint32_t blockSize)
+    {
+        this->m_device = device;
+        this->m_flags = flags;
+        this->m_blockSize = blockSize;
+        this->m_pool.emplace(device, flags, blockSize);
+
+        if (this->m_telemetry < 0)
+            this->m_telemetry = MemoryTelemetry::registerPool(this->m_name, blockSize);
+    }
+
+    bool GpuPool::isCreated()
+    {
+        return this->m_pool.has_value();
+    }
+
+    CMemPool& GpuPool::get()
+    {
+        return *this->m_pool;
+    }
+
+    CMemPool::Handle GpuPool::allocate(uint32_t size, uint32_t alignment)
+    {
+        CMemPool::Handle handle = this->m_pool->allocate(size, alignment);
+        GpuPoolStats stats;
+        DkMemBlock block;
+
+        if (!handle)
+        {
+            EXUI_LOG_ERROR("GPU pool {}: failed to allocate {} bytes", this->m_name, size);
+            return handle;
+        }
+
+        block = handle.getMemBlock();
+        if (std::none_of(this->m_blocks.begin(), this->m_blocks.end(), [block](const Block& b) { return b.block == block; }))
+        {
+            this->m_blocks.push_back({ block, dkMemBlockGetSize(block) });
+
+            if (this->m_blocks.size() > 1)
+                EXUI_LOG_INFO("GPU pool {} grew to {} blocks for a {} byte allocation", this->m_name, this->m_blocks.size(), size);
+        }
+
+        this->m_extents.push_back({ block, handle.getOffset(), handle.getSize() });
+        MemoryTelemetry::poolAllocated(this->m_telemetry, handle.getSize());
+
+        stats = this->getStats();
+        MemoryTelemetry::poolLayout(this->m_telemetry, this->m_blockSize, stats.blocks, stats.reserved, stats.largestFree);
+        return handle;
+    }
+
+    void GpuPool::free(CMemPool::Handle& handle)
+    {
+        DkMemBlock block;
+        uint32_t offset;
+        GpuPoolStats stats;
+
+        if (!handle)
+            return;
+
+        block = handle.getMemBlock();
+        offset = handle.getOffset();
+
+        auto it = std::find_if(this->m_extents.begin(), this->m_extents.end(),
+            [block, offset](const Extent& e) { return e.block == block && e.offset == offset; });
+        if (it != this->m_extents.end())
+        {
+            *it = this->m_extents.back();
+            this->m_extents.pop_back();
+        }
+
+        MemoryTelemetry::poolFreed(this->m_telemetry, handle.getSize());
+        handle.destroy();
+
+        stats = this->getStats();
+        MemoryTelemetry::poolLayout(this->m_telemetry, this->m_blockSize, stats.blocks, stats.reserved, stats.largestFree);
+    }
+
+    bool GpuPool::compact(uint32_t blockSize)
+    {
+        if (!this->m_extents.empty())
+            return false;
+
+        /* Destroying the CMemPool releases all of its blocks, including
+         * those it grew and kept around empty */
+        this->m_pool.reset();
+        this->m_blocks.clear();
+        this->create(this->m_device, this->m_flags, blockSize);
+
+        MemoryTelemetry::poolLayout(this->m_telemetry, blockSize, 0, 0, 0);
+        return true;
+    }
+
+    GpuPoolStats GpuPool::getStats()
+    {
+        GpuPoolStats stats = {};
+        std::vector<Extent> extents = this->m_extents;
+        uint32_t end;
+
+        stats.blocks = (uint32_t)this->m_blocks.size();
+        stats.growths = stats.blocks > 1 ? stats.blocks - 1 : 0;
+
+        /* Gaps between allocations, block by block */
+        std::sort(extents.begin(), extents.end(), [](const Extent& a, const Extent& b) {
+            return a.block != b.block ? a.block < b.block : a.offset < b.offset;
+        });
+
+        for (const Block& block : this->m_blocks)
+        {
+            end = 0;
+            stats.reserved += block.size;
+
+            for (const Extent& e : extents)
+            {
+                if (e.block != block.block)
+                    continue;
+
+                stats.largestFree = std::max<uint64_t>(stats.largestFree, e.offset - std::min(e.offset, end));
+                stats.used += e.size;
+                end = std::max(end, e.offset + e.size);
+            }
+
+            stats.largestFree = std::max<uint64_t>(stats.largestFree, block.size - std::min(block.size, end));
+        }
+
+        if (stats.reserved > stats.used)
+            stats.fragmentation = 1.0f - (float)stats.largestFree / (stats.reserved - stats.used);
+
+        return stats;
+    }
+
+    uint32_t GpuPool::getBlockSize()
+    {
+        return this->m_blockSize;
+    }
+} // namespace eXUI
@@ -0,0 +1,227 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/input_log.hpp"
+#include <string.h>
+
+namespace eXUI
+{
+    static const char input_log_magic[4] = { 'E', 'X', 'I', 'R' };
+
+    /* Records are buffered and written out in blocks of this size */
+    #define INPUT_LOG_FLUSH_SIZE 4096
+
+    static void input_log_put_varint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    InputRecorder::InputRecorder()
+        : m_file(nullptr),
+        m_lastNs(0),
+        m_lastHeld(0)
+    {
+    }
+
+    InputRecorder::~InputRecorder()
+    {
+        this->close();
+    }
+
+    bool InputRecorder::open(const char* path)
+    {
+        uint8_t header[8] = { 0 };
+
+        this->close();
+
+        if (!(this->m_file = fopen(path, "wb")))
+            return false;
+
+        memcpy(header, input_log_magic, sizeof(input_log_magic));
+        header[4] = INPUT_LOG_VERSION;
+        fwrite(header, 1, sizeof(header), this->m_file);
+
+        this->m_buffer.reserve(INPUT_LOG_FLUSH_SIZE + 64);
+        this->m_lastNs   = 0;
+        this->m_lastHeld = 0;
+        return true;
+    }
+
+    void InputRecorder::close()
+    {
+        if (!this->m_file)
+            return;
+
+        this->flush();
+        fclose(this->m_file);
+        this->m_file = nullptr;
+    }
+
+    bool InputRecorder::isOpen()
+    {
+        return this->m_file != nullptr;
+    }
+
+    void InputRecorder::flush()
+    {
+        if (!this->m_buffer.empty())
+            fwrite(this->m_buffer.data(), 1, this->m_buffer.size(), this->m_file);
+        this->m_buffer.clear();
+    }
+
+    void InputRecorder::record(const InputFrame& frame)
+    {
+        uint64_t derivedDown = frame.held & ~this->m_lastHeld;
+        uint64_t derivedUp   = this->m_lastHeld & ~frame.held;
+        uint8_t flags        = 0;
+
+        if (!this->m_file)
+            return;
+
+        if (frame.held != this->m_lastHeld)
+            flags |= INPUT_LOG_HELD;
+        if (frame.down != derivedDown)
+            flags |= INPUT_LOG_DOWN;
+        if (frame.up != derivedUp)
+            flags |= INPUT_LOG_UP;
+
+        this->m_buffer.push_back(flags);
+        input_log_put_varint(this->m_buffer, frame.ns - this->m_lastNs);
+        if (flags & INPUT_LOG_HELD)
+            input_log_put_varint(this->m_buffer, frame.held);
+        if (flags & INPUT_LOG_DOWN)
+            input_log_put_varint(this->m_buffer, frame.down);
+        if (flags & INPUT_LOG_UP)
+            input_log_put_varint(this->m_buffer, frame.up);
+
+        this->m_lastNs   = frame.ns;
+        this->m_lastHeld = frame.held;
+
+        if (this->m_buffer.size() >= INPUT_LOG_FLUSH_SIZE)
+            this->flush();
+    }
+
+    InputReplayer::InputReplayer()
+        : m_pos(0),
+        m_frame(0),
+        m_lastNs(0),
+        m_lastHeld(0)
+    {
+    }
+
+    bool InputReplayer::open(const char* path)
+    {
+        FILE* file = fopen(path, "rb");
+        long size;
+
+        this->m_data.clear();
+        this->m_pos      = 0;
+        this->m_frame    = 0;
+        this->m_lastNs   = 0;
+        this->m_lastHeld = 0;
+
+        if (!file)
+            return false;
+
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if (size >= 8)
+        {
+            this->m_data.resize(size);
+            if (fread(this->m_data.data(), 1, size, file) != (size_t)size)
+                this->m_data.clear();
+        }
+        fclose(file);
+
+        if (this->m_data.size() < 8
+            || memcmp(this->m_data.data(), input_log_magic, sizeof(input_log_magic))
+            || this->m_data[4] != INPUT_LOG_VERSION)
+        {
+            this->m_data.clear();
+            return false;
+        }
+
+        this->m_pos = 8;
+        return true;
+    }
+
+    bool InputReplayer::isOpen()
+    {
+        return !this->m_data.empty();
+    }
+
+    uint32_t InputReplayer::getFrame()
+    {
+        return this->m_frame;
+    }
+
+    bool InputReplayer::readVarint(uint64_t& value)
+    {
+        int shift = 0;
+
+        value = 0;
+        while (this->m_pos < this->m_data.size() && shift < 64)
+        {
+            uint8_t byte = this->m_data[this->m_pos++];
+
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+            shift += 7;
+        }
+
+        return false;
+    }
+
+    bool InputReplayer::next(InputFrame& frame)
+    {
+        uint64_t delta;
+        uint8_t flags;
+
+        if (this->m_pos >= this->m_data.size())
+            return false;
+
+        flags = this->m_data[this->m_pos++];
+        if (!this->readVarint(delta))
+            return false;
+
+        frame.ns   = this->m_lastNs + delta;
+        frame.held = this->m_lastHeld;
+        if ((flags & INPUT_LOG_HELD) && !this->readVarint(frame.held))
+            return false;
+
+        frame.down = frame.held & ~this->m_lastHeld;
+        frame.up   = this->m_lastHeld & ~frame.held;
+        if ((flags & INPUT_LOG_DOWN) && !this->readVarint(frame.down))
+            return false;
+        if ((flags & INPUT_LOG_UP) && !this->readVarint(frame.up))
+            return false;
+
+        this->m_lastNs   = frame.ns;
+        this->m_lastHeld = frame.held;
+        this->m_frame++;
+        return true;
+    }
+} // namespace eXUI
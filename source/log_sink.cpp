@@ -0,0 +1,249 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/log_sink.hpp"
+#include "eXUI/logger.hpp"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+namespace eXUI
+{
+    FileLogSink::FileLogSink(const std::string& path, size_t maxSize, unsigned keep, size_t bufferSize)
+        : m_path(path), m_maxSize(maxSize), m_keep(keep), m_file(nullptr), m_size(0), m_buffer(bufferSize), m_used(0)
+    {
+        this->open();
+    }
+
+    FileLogSink::~FileLogSink()
+    {
+        this->flush();
+
+        if (this->m_file)
+            fclose(this->m_file);
+    }
+
+    bool FileLogSink::isOpen()
+    {
+        return this->m_file != nullptr;
+    }
+
+    void FileLogSink::open()
+    {
+        /* Appends to what a previous run left, so its size counts
+         * toward the next rotation */
+        if ((this->m_file = fopen(this->m_path.c_str(), "ab")))
+        {
+            setvbuf(this->m_file, nullptr, _IONBF, 0); // m_buffer does the buffering
+            fseek(this->m_file, 0, SEEK_END);
+            this->m_size = (size_t)ftell(this->m_file);
+        }
+    }
+
+    void FileLogSink::rotate()
+    {
+        std::string from, to;
+        unsigned i;
+
+        this->flush();
+        fclose(this->m_file);
+        this->m_file = nullptr;
+
+        if (this->m_keep == 0)
+            remove(this->m_path.c_str());
+
+        /* path.keep is dropped, path.n moves to path.n+1 */
+        for (i = this->m_keep; i > 0; i--)
+        {
+            to   = this->m_path + "." + std::to_string(i);
+            from = i > 1 ? this->m_path + "." + std::to_string(i - 1) : this->m_path;
+            remove(to.c_str());
+            rename(from.c_str(), to.c_str());
+        }
+
+        this->open();
+    }
+
+    void FileLogSink::write(const char* data, size_t length)
+    {
+        size_t room, chunk;
+        const char* cut;
+
+        while (length && this->m_file)
+        {
+            chunk = length;
+            room  = this->m_size + this->m_used < this->m_maxSize ? this->m_maxSize - this->m_size - this->m_used : 0;
+
+            /* Rotates on the last line boundary that still fits, so
+             * files only ever hold whole lines */
+            if (this->m_maxSize && length > room)
+            {
+                cut = room ? (const char*)memrchr(data, '\n', room) : nullptr;
+
+                if (cut)
+                    chunk = cut + 1 - data;
+                else if (this->m_size + this->m_used > 0)
+                {
+                    this->rotate();
+                    continue;
+                }
+            }
+
+            this->append(data, chunk);
+            data += chunk;
+            length -= chunk;
+        }
+    }
+
+    void FileLogSink::append(const char* data, size_t length)
+    {
+        if (this->m_used + length > this->m_buffer.size())
+            this->flush();
+
+        // Anything larger than the whole buffer goes straight through
+        if (length > this->m_buffer.size())
+        {
+            this->m_size += fwrite(data, 1, length, this->m_file);
+            return;
+        }
+
+        memcpy(this->m_buffer.data() + this->m_used, data, length);
+        this->m_used += length;
+    }
+
+    void FileLogSink::flush()
+    {
+        if (!this->m_file || !this->m_used)
+            return;
+
+        this->m_size += fwrite(this->m_buffer.data(), 1, this->m_used, this->m_file);
+        this->m_used = 0;
+    }
+
+    SocketLogSink::SocketLogSink(int socket, size_t batchSize)
+        : m_socket(socket), m_buffer(batchSize), m_used(0), m_dropped(0)
+    {
+    }
+
+    void SocketLogSink::write(const char* data, size_t length)
+    {
+        size_t chunk;
+
+        while (length)
+        {
+            if (this->m_used == this->m_buffer.size())
+                this->flush();
+
+            chunk = std::min(length, this->m_buffer.size() - this->m_used);
+            memcpy(this->m_buffer.data() + this->m_used, data, chunk);
+            this->m_used += chunk;
+            data += chunk;
+            length -= chunk;
+        }
+    }
+
+    void SocketLogSink::flush()
+    {
+        size_t sent = 0;
+        ssize_t n;
+
+        if (this->m_socket < 0)
+        {
+            this->m_dropped += this->m_used;
+            this->m_used = 0;
+            return;
+        }
+
+        while (sent < this->m_used)
+        {
+            if ((n = send(this->m_socket, this->m_buffer.data() + sent, this->m_used - sent, 0)) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                // The host went away; keep logging to the other sinks
+                this->m_dropped += this->m_used - sent;
+                this->m_socket = -1;
+                break;
+            }
+
+            sent += (size_t)n;
+        }
+
+        this->m_used = 0;
+    }
+
+    size_t SocketLogSink::getDroppedBytes()
+    {
+        return this->m_dropped;
+    }
+
+    RingLogSink::RingLogSink(size_t capacity)
+        : m_lines(capacity ? capacity : 1), m_next(0), m_count(0)
+    {
+        // Lines are reassigned in place, so steady state never allocates
+        for (std::string& line : this->m_lines)
+            line.reserve(LOG_RECORD_SIZE);
+    }
+
+    void RingLogSink::write(const char* data, size_t length)
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        const char* end = data + length;
+        const char* newline;
+
+        while (data < end)
+        {
+            if (!(newline = (const char*)memchr(data, '\n', end - data)))
+            {
+                this->m_partial.append(data, end - data);
+                break;
+            }
+
+            std::string& line = this->m_lines[this->m_next];
+            if (this->m_partial.empty())
+                line.assign(data, newline - data);
+            else
+            {
+                line.assign(this->m_partial);
+                line.append(data, newline - data);
+                this->m_partial.clear();
+            }
+
+            this->m_next  = (this->m_next + 1) % this->m_lines.size();
+            this->m_count = std::min(this->m_count + 1, this->m_lines.size());
+            data = newline + 1;
+        }
+    }
+
+    std::vector<std::string> RingLogSink::getLastLines(size_t count)
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        std::vector<std::string> lines;
+        size_t i, first;
+
+        count = std::min(count, this->m_count);
+        first = (this->m_next + this->m_lines.size() - count) % this->m_lines.size();
+        lines.reserve(count);
+
+        for (i = 0; i < count; i++)
+            lines.push_back(this->m_lines[(first + i) % this->m_lines.size()]);
+
+        return lines;
+    }
+} // namespace eXUI
@@ -18,11 +18,448 @@
 */
 
 #include "eXUI/logger.hpp"
+#include "eXUI/log_sink.hpp"
+#include <chrono>
+#include <fmt/args.h>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace eXUI
 {
+    // Lines are gathered into writes of up to this many bytes
+    #define LOGGER_BATCH_SIZE 0x4000
+    // The writer flushes sinks at most this often while lines keep coming
+    #define LOGGER_FLUSH_INTERVAL std::chrono::milliseconds(100)
+
+    /* Bounded MPSC ring (Vyukov): a record whose sequence equals the
+     * producer position is free, position + 1 means published. */
+    static LogRecord* logger_ring = nullptr;
+    static std::atomic<uint32_t> logger_tail = 0; // next record to reserve
+    static std::atomic<uint32_t> logger_head = 0; // next record to write out
+    static std::atomic<uint32_t> logger_dropped = 0;
+    // Producers between the async check in acquire() and commit()
+    static std::atomic<uint32_t> logger_producers = 0;
+    static LogOverflow logger_overflow = LogOverflow::DROP;
+
+    static std::thread logger_writer;
+    static std::atomic<bool> logger_running = false;
+    static char logger_batch[LOGGER_BATCH_SIZE];
+
+    // Registered sinks, stdout when there are none
+    static std::mutex logger_sinks_mutex;
+    static std::vector<LogSink*> logger_sinks;
+    static bool logger_unflushed = false;
+
+    /* Binary log, "EXLB" then a u32 version, followed by entries:
+     *  'S' u32 id, u16 length, text                  format string, once per id
+     *  'R' u8 level, u64 timestamp, u32 id, u16 length, encoded arguments */
+    #define LOGGER_BINARY_VERSION 1
+    static FILE* logger_binary = nullptr;
+    static std::unordered_map<const char*, uint32_t> logger_formats;
+
+    static const char* const logger_level_names[]  = { "ERROR", "WARNING", "INFO", "DEBUG" };
+    static const char* const logger_level_colors[] = { "[0;31m", "[0;33m", "[0;34m", "[0;32m" };
+
     void Logger::setLogLevel(LogLevel newLogLevel)
     {
         Logger::logLevel = newLogLevel;
     }
-} // namespace eXUI
\ No newline at end of file
+
+    // Callers hold logger_sinks_mutex
+    static void logger_emit(const char* data, size_t length)
+    {
+        if (logger_sinks.empty())
+            fwrite(data, 1, length, stdout);
+
+        for (LogSink* sink : logger_sinks)
+            sink->write(data, length);
+
+        logger_unflushed = true;
+    }
+
+    static void logger_flush_sinks()
+    {
+        if (!logger_unflushed)
+            return;
+
+        if (logger_sinks.empty())
+            fflush(stdout);
+
+        for (LogSink* sink : logger_sinks)
+            sink->flush();
+
+        logger_unflushed = false;
+    }
+
+    void Logger::addSink(LogSink* sink)
+    {
+        // Lines logged so far still go to the previous sinks
+        Logger::flush();
+
+        std::lock_guard<std::mutex> lock(logger_sinks_mutex);
+        logger_sinks.push_back(sink);
+    }
+
+    void Logger::removeSink(LogSink* sink)
+    {
+        Logger::flush();
+
+        std::lock_guard<std::mutex> lock(logger_sinks_mutex);
+        auto it = std::find(logger_sinks.begin(), logger_sinks.end(), sink);
+
+        if (it != logger_sinks.end())
+            logger_sinks.erase(it);
+    }
+
+    static size_t logger_header(LogLevel level, char* out, size_t size)
+    {
+        int n = snprintf(out, size, "\033%s[%s]\033[0m ", logger_level_colors[(int)level], logger_level_names[(int)level]);
+
+        return n > 0 ? std::min(size, (size_t)n) : 0;
+    }
+
+    size_t Logger::writeHeader(LogLevel level, char* out, size_t size)
+    {
+        return logger_header(level, out, size);
+    }
+
+    std::string Logger::formatDeferred(const char* format, const char* args, size_t length)
+    {
+        fmt::dynamic_format_arg_store<fmt::format_context> store;
+        const char* end = args + length;
+
+        while (args < end)
+        {
+            uint8_t tag = (uint8_t)*args++;
+            uint16_t size;
+            int64_t i64;
+            uint64_t u64;
+            double f64;
+
+            switch (tag)
+            {
+                case LOG_ARG_I64:
+                    if (end - args < (ptrdiff_t)sizeof(i64))
+                        break;
+                    memcpy(&i64, args, sizeof(i64));
+                    args += sizeof(i64);
+                    store.push_back(i64);
+                    continue;
+                case LOG_ARG_U64:
+                case LOG_ARG_PTR:
+                    if (end - args < (ptrdiff_t)sizeof(u64))
+                        break;
+                    memcpy(&u64, args, sizeof(u64));
+                    args += sizeof(u64);
+                    if (tag == LOG_ARG_PTR)
+                        store.push_back((const void*)(uintptr_t)u64);
+                    else
+                        store.push_back(u64);
+                    continue;
+                case LOG_ARG_F64:
+                    if (end - args < (ptrdiff_t)sizeof(f64))
+                        break;
+                    memcpy(&f64, args, sizeof(f64));
+                    args += sizeof(f64);
+                    store.push_back(f64);
+                    continue;
+                case LOG_ARG_BOOL:
+                    if (end - args < 1)
+                        break;
+                    store.push_back(*args++ != 0);
+                    continue;
+                case LOG_ARG_CHAR:
+                    if (end - args < 1)
+                        break;
+                    store.push_back(*args++);
+                    continue;
+                case LOG_ARG_STR:
+                    if (end - args < (ptrdiff_t)sizeof(size))
+                        break;
+                    memcpy(&size, args, sizeof(size));
+                    args += sizeof(size);
+                    size = (uint16_t)std::min<ptrdiff_t>(size, end - args);
+                    store.push_back(std::string(args, size));
+                    args += size;
+                    continue;
+                default:
+                    break;
+            }
+
+            break; // unknown tag or truncated record
+        }
+
+        try
+        {
+            return fmt::vformat(format, store);
+        }
+        catch (const std::exception& e)
+        {
+            return fmt::format("! Invalid deferred log record: \"{}\": {}", format, e.what());
+        }
+    }
+
+    bool Logger::openBinaryLog(const char* path)
+    {
+        uint32_t version = LOGGER_BINARY_VERSION;
+
+        Logger::closeBinaryLog();
+
+        if (!(logger_binary = fopen(path, "wb")))
+            return false;
+
+        fwrite("EXLB", 1, 4, logger_binary);
+        fwrite(&version, sizeof(version), 1, logger_binary);
+        return true;
+    }
+
+    void Logger::closeBinaryLog()
+    {
+        Logger::flush();
+
+        if (logger_binary)
+        {
+            fclose(logger_binary);
+            logger_binary = nullptr;
+        }
+
+        logger_formats.clear();
+    }
+
+    static void logger_write_binary(const LogRecord* record)
+    {
+        auto it     = logger_formats.find(record->format);
+        uint8_t level = (uint8_t)record->level;
+        uint16_t length;
+        uint32_t id;
+
+        if (it == logger_formats.end())
+        {
+            id     = (uint32_t)logger_formats.size();
+            length = (uint16_t)std::min<size_t>(strlen(record->format), UINT16_MAX);
+            logger_formats.emplace(record->format, id);
+
+            fputc('S', logger_binary);
+            fwrite(&id, sizeof(id), 1, logger_binary);
+            fwrite(&length, sizeof(length), 1, logger_binary);
+            fwrite(record->format, 1, length, logger_binary);
+        }
+        else
+            id = it->second;
+
+        length = (uint16_t)record->length;
+        fputc('R', logger_binary);
+        fwrite(&level, sizeof(level), 1, logger_binary);
+        fwrite(&record->timestamp, sizeof(record->timestamp), 1, logger_binary);
+        fwrite(&id, sizeof(id), 1, logger_binary);
+        fwrite(&length, sizeof(length), 1, logger_binary);
+        fwrite(record->text, 1, length, logger_binary);
+    }
+
+    LogRecord* Logger::acquire()
+    {
+        uint32_t pos;
+
+        // Counted before the check so stopAsync() either sees this
+        // producer or the producer sees async cleared
+        logger_producers.fetch_add(1);
+        if (!Logger::async.load())
+        {
+            logger_producers.fetch_sub(1, std::memory_order_release);
+            return nullptr;
+        }
+
+        pos = logger_tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            LogRecord* record = &logger_ring[pos & (LOG_RING_SIZE - 1)];
+            int32_t diff      = (int32_t)(record->sequence.load(std::memory_order_acquire) - pos);
+
+            if (diff == 0)
+            {
+                if (logger_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return record;
+            }
+            else if (diff < 0)
+            {
+                // full: the writer has not freed this record yet
+                if (logger_overflow == LogOverflow::DROP)
+                {
+                    logger_dropped.fetch_add(1, std::memory_order_relaxed);
+                    logger_producers.fetch_sub(1, std::memory_order_release);
+                    return nullptr;
+                }
+
+                std::this_thread::yield();
+                pos = logger_tail.load(std::memory_order_relaxed);
+            }
+            else
+                pos = logger_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    void Logger::commit(LogRecord* record, const char* text, size_t length)
+    {
+        if (!record)
+        {
+            std::lock_guard<std::mutex> lock(logger_sinks_mutex);
+            logger_emit(text, length);
+            logger_flush_sinks();
+            return;
+        }
+
+        record->length = (uint32_t)length;
+        record->sequence.store(record->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        logger_producers.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Writer side: moves every published record into batched writes
+    static bool logger_drain()
+    {
+        std::lock_guard<std::mutex> lock(logger_sinks_mutex);
+        uint32_t head = logger_head.load(std::memory_order_relaxed);
+        uint32_t dropped;
+        size_t used = 0;
+        bool wrote  = false;
+
+        for (;;)
+        {
+            LogRecord* record = &logger_ring[head & (LOG_RING_SIZE - 1)];
+
+            if (record->sequence.load(std::memory_order_acquire) != head + 1)
+                break;
+
+            if (record->kind == LogRecordKind::DEFERRED && logger_binary)
+                logger_write_binary(record);
+            else
+            {
+                char line[LOG_RECORD_SIZE * 2];
+                const char* text = record->text;
+                size_t length    = record->length;
+
+                if (record->kind == LogRecordKind::DEFERRED)
+                {
+                    std::string body = Logger::formatDeferred(record->format, record->text, record->length);
+
+                    // A long body is cut short of the newline, which
+                    // always ends the line
+                    length = std::min(logger_header(record->level, line, sizeof(line)), sizeof(line) - 1);
+                    size_t room = std::min(body.size(), sizeof(line) - 1 - length);
+                    memcpy(line + length, body.data(), room);
+                    length += room;
+                    line[length++] = '\n';
+                    text   = line;
+                }
+
+                if (used + length > sizeof(logger_batch))
+                {
+                    logger_emit(logger_batch, used);
+                    used = 0;
+                }
+
+                memcpy(logger_batch + used, text, length);
+                used += length;
+            }
+
+            record->sequence.store(head + LOG_RING_SIZE, std::memory_order_release);
+            logger_head.store(++head, std::memory_order_release);
+            wrote = true;
+        }
+
+        if ((dropped = logger_dropped.exchange(0, std::memory_order_relaxed)))
+        {
+            int n = snprintf(logger_batch + used, sizeof(logger_batch) - used, "! %u log lines dropped\n", (unsigned)dropped);
+            if (n > 0 && used + n < sizeof(logger_batch))
+                used += n;
+        }
+
+        if (used)
+            logger_emit(logger_batch, used);
+
+        if (wrote && logger_binary)
+            fflush(logger_binary);
+
+        return wrote;
+    }
+
+    static void logger_writer_main()
+    {
+        auto lastFlush = std::chrono::steady_clock::now();
+        bool wrote;
+
+        while (logger_running.load())
+        {
+            wrote = logger_drain();
+
+            // Sinks see one flush per interval during bursts, and one as
+            // soon as output goes quiet
+            if (!wrote || std::chrono::steady_clock::now() - lastFlush >= LOGGER_FLUSH_INTERVAL)
+            {
+                std::lock_guard<std::mutex> lock(logger_sinks_mutex);
+                logger_flush_sinks();
+                lastFlush = std::chrono::steady_clock::now();
+            }
+
+            if (!wrote)
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        logger_drain();
+    }
+
+    void Logger::startAsync(LogOverflow overflow)
+    {
+        uint32_t i;
+
+        if (Logger::async.load())
+            return;
+
+        if (!logger_ring)
+            logger_ring = new LogRecord[LOG_RING_SIZE];
+
+        for (i = 0; i < LOG_RING_SIZE; i++)
+            logger_ring[i].sequence.store(i, std::memory_order_relaxed);
+        logger_tail.store(0);
+        logger_head.store(0);
+        logger_dropped.store(0);
+        logger_overflow = overflow;
+
+        logger_running.store(true);
+        logger_writer = std::thread(logger_writer_main);
+        Logger::async.store(true, std::memory_order_release);
+    }
+
+    void Logger::stopAsync()
+    {
+        if (!Logger::async.load())
+            return;
+
+        // New lines go out synchronously from here on; lines that
+        // already passed the check in acquire() are published before
+        // the final flush, and drained before the join returns
+        Logger::async.store(false);
+        while (logger_producers.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        Logger::flush();
+        logger_running.store(false);
+        logger_writer.join();
+    }
+
+    void Logger::flush()
+    {
+        uint32_t tail = logger_tail.load(std::memory_order_acquire);
+
+        if (logger_running.load())
+        {
+            while ((int32_t)(logger_head.load(std::memory_order_acquire) - tail) < 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::lock_guard<std::mutex> lock(logger_sinks_mutex);
+        logger_flush_sinks();
+    }
+} // namespace eXUI
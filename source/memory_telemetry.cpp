@@ -0,0 +1,270 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/memory_telemetry.hpp"
+#include "eXUI/trace.hpp"
+#include <atomic>
+#include <malloc.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__SWITCH__)
+/* Bounds of the heap newlib's sbrk hands out, set up by libnx */
+extern "C" char* fake_heap_start;
+extern "C" char* fake_heap_end;
+#endif
+
+namespace eXUI
+{
+    static MemoryPoolUsage memory_pools[MEMORY_MAX_POOLS];
+    static int memory_pool_count = 0;
+
+    /* Written by any thread through the operator new/delete hooks */
+    static std::atomic<uint64_t> memory_frame_allocations = 0;
+    static std::atomic<uint64_t> memory_frame_frees       = 0;
+    static std::atomic<uint64_t> memory_frame_bytes       = 0;
+
+    static MemoryFrameStats memory_history[GRAPH_HISTORY_COUNT];
+    static int memory_head = 0;
+    static uint64_t memory_frames = 0;
+    static uint64_t memory_heap_peak = 0;
+    static uint64_t memory_heap_used = 0;
+    static uint64_t memory_heap_size = 0;
+
+    /* Constructed on first use, the hooks may run before static init */
+    static PerfGraph* memory_heap_graph()
+    {
+        static PerfGraph graph(RenderStyle::PERCENT, "Heap");
+        return &graph;
+    }
+
+    static PerfGraph* memory_alloc_graph()
+    {
+        static PerfGraph graph(RenderStyle::COUNT, "Allocations / frame");
+        return &graph;
+    }
+
+    int MemoryTelemetry::registerPool(const char* name, uint64_t blockSize)
+    {
+        MemoryPoolUsage* pool;
+
+        if (memory_pool_count >= MEMORY_MAX_POOLS)
+            return -1;
+
+        pool              = &memory_pools[memory_pool_count];
+        pool->name        = name;
+        pool->blockSize   = blockSize;
+        pool->current     = 0;
+        pool->peak        = 0;
+        pool->live        = 0;
+        pool->allocations = 0;
+        pool->blocks      = 0;
+        pool->reserved    = 0;
+        pool->largestFree = 0;
+
+        return memory_pool_count++;
+    }
+
+    void MemoryTelemetry::poolAllocated(int pool, uint64_t size)
+    {
+        MemoryPoolUsage* p;
+
+        if (pool < 0 || pool >= memory_pool_count)
+            return;
+
+        p = &memory_pools[pool];
+        p->current += size;
+        p->live++;
+        p->allocations++;
+        if (p->current > p->peak)
+            p->peak = p->current;
+    }
+
+    void MemoryTelemetry::poolFreed(int pool, uint64_t size)
+    {
+        MemoryPoolUsage* p;
+
+        if (pool < 0 || pool >= memory_pool_count)
+            return;
+
+        p = &memory_pools[pool];
+        p->current -= size;
+        p->live--;
+    }
+
+    void MemoryTelemetry::poolLayout(int pool, uint64_t blockSize, uint32_t blocks, uint64_t reserved, uint64_t largestFree)
+    {
+        MemoryPoolUsage* p;
+
+        if (pool < 0 || pool >= memory_pool_count)
+            return;
+
+        p              = &memory_pools[pool];
+        p->blockSize   = blockSize;
+        p->blocks      = blocks;
+        p->reserved    = reserved;
+        p->largestFree = largestFree;
+    }
+
+    void MemoryTelemetry::endFrame()
+    {
+        MemoryFrameStats* frame;
+
+        if (memory_frames % MEMORY_HEAP_SAMPLE_FRAMES == 0)
+        {
+            struct mallinfo info = mallinfo();
+
+            memory_heap_used = (uint64_t)info.uordblks;
+#if defined(__SWITCH__)
+            memory_heap_size = (uint64_t)(fake_heap_end - fake_heap_start);
+#else
+            memory_heap_size = (uint64_t)info.arena;
+#endif
+        }
+
+        memory_head = (memory_head + 1) % GRAPH_HISTORY_COUNT;
+        frame       = &memory_history[memory_head];
+
+        frame->allocations = memory_frame_allocations.exchange(0, std::memory_order_relaxed);
+        frame->frees       = memory_frame_frees.exchange(0, std::memory_order_relaxed);
+        frame->bytes       = memory_frame_bytes.exchange(0, std::memory_order_relaxed);
+        frame->heapUsed    = memory_heap_used;
+        frame->heapSize    = memory_heap_size;
+        memory_frames++;
+
+        if (frame->heapUsed > memory_heap_peak)
+            memory_heap_peak = frame->heapUsed;
+
+        memory_heap_graph()->update(frame->heapSize ? 100.0f * frame->heapUsed / frame->heapSize : 0.0f);
+        memory_alloc_graph()->update((float)frame->allocations);
+
+#if defined(EXUI_PROFILER)
+        Trace::counter("heap used", (int64_t)frame->heapUsed);
+        Trace::counter("allocations", (int64_t)frame->allocations);
+#endif /* EXUI_PROFILER */
+    }
+
+    int MemoryTelemetry::getPoolCount()
+    {
+        return memory_pool_count;
+    }
+
+    const MemoryPoolUsage* MemoryTelemetry::getPool(int pool)
+    {
+        if (pool < 0 || pool >= memory_pool_count)
+            return nullptr;
+
+        return &memory_pools[pool];
+    }
+
+    const MemoryFrameStats& MemoryTelemetry::getLastFrame()
+    {
+        return memory_history[memory_head];
+    }
+
+    uint64_t MemoryTelemetry::getHeapPeak()
+    {
+        return memory_heap_peak;
+    }
+
+    bool MemoryTelemetry::hooksEnabled()
+    {
+#if defined(EXUI_MEMORY_HOOKS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void MemoryTelemetry::layout(PerfOverlay& overlay, float x, float y)
+    {
+        overlay.add(memory_heap_graph(), x, y);
+
+        if (MemoryTelemetry::hooksEnabled())
+            overlay.add(memory_alloc_graph(), x + GRAPH_WIDTH + 5.0f, y);
+    }
+
+    bool MemoryTelemetry::exportCsv(const char* path)
+    {
+        FILE* file = fopen(path, "w");
+        uint64_t frames, i;
+        int p;
+
+        if (!file)
+            return false;
+
+        fprintf(file, "pool,block_size,current,peak,live,allocations,blocks,reserved,largest_free\n");
+        for (p = 0; p < memory_pool_count; p++)
+        {
+            const MemoryPoolUsage* pool = &memory_pools[p];
+
+            fprintf(file, "%s,%llu,%llu,%llu,%u,%u,%u,%llu,%llu\n", pool->name,
+                (unsigned long long)pool->blockSize, (unsigned long long)pool->current,
+                (unsigned long long)pool->peak, (unsigned)pool->live, (unsigned)pool->allocations,
+                (unsigned)pool->blocks, (unsigned long long)pool->reserved, (unsigned long long)pool->largestFree);
+        }
+
+        /* Oldest frame first */
+        frames = memory_frames < GRAPH_HISTORY_COUNT ? memory_frames : GRAPH_HISTORY_COUNT;
+        fprintf(file, "\nframe,allocations,frees,bytes,heap_used,heap_size\n");
+        for (i = 0; i < frames; i++)
+        {
+            int slot = (int)((memory_head + GRAPH_HISTORY_COUNT - frames + 1 + i) % GRAPH_HISTORY_COUNT);
+            const MemoryFrameStats* frame = &memory_history[slot];
+
+            fprintf(file, "%llu,%llu,%llu,%llu,%llu,%llu\n",
+                (unsigned long long)(memory_frames - frames + i),
+                (unsigned long long)frame->allocations, (unsigned long long)frame->frees,
+                (unsigned long long)frame->bytes, (unsigned long long)frame->heapUsed,
+                (unsigned long long)frame->heapSize);
+        }
+
+        fclose(file);
+        return true;
+    }
+} // namespace eXUI
+
+#if defined(EXUI_MEMORY_HOOKS)
+/* Replacement global operators, counting into the current frame.
+ * Array and nothrow forms forward to these in libstdc++. */
+void* operator new(size_t size)
+{
+    void* ptr;
+
+    eXUI::memory_frame_allocations.fetch_add(1, std::memory_order_relaxed);
+    eXUI::memory_frame_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if ((ptr = malloc(size ? size : 1)))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr)
+        eXUI::memory_frame_frees.fetch_add(1, std::memory_order_relaxed);
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+#endif /* EXUI_MEMORY_HOOKS */
@@ -1,31 +1,170 @@
 #include "eXUI/perf.hpp"
+#include <math.h>
+#include <stdio.h>
 
 namespace eXUI
 {
+	static int histogramBucket(float value)
+	{
+		int bucket;
+
+		if (!(value >= GRAPH_HISTOGRAM_MIN))
+			return 0;
+
+		bucket = 1 + (int)(log2f(value / GRAPH_HISTOGRAM_MIN) * GRAPH_HISTOGRAM_STEPS);
+		return bucket < GRAPH_HISTOGRAM_BUCKETS ? bucket : GRAPH_HISTOGRAM_BUCKETS - 1;
+	}
+
+	// Upper bound of a histogram bucket
+	static float histogramBound(int bucket)
+	{
+		return GRAPH_HISTOGRAM_MIN * exp2f((float)bucket / GRAPH_HISTOGRAM_STEPS);
+	}
+
 	PerfGraph::PerfGraph(RenderStyle style, std::string name)
-		: values(), head(0)
+		: values(), buckets(), histogram(), head(0), count(0), sum(0.0),
+		minQueue(), maxQueue(), valueKey(-1), detailKey(-1), tailKey{-1, -1},
+		valueText(), detailText(), tailText()
 	{
 		this->style = style;
 		this->name = name;
+		for (int i = 0; i < GRAPH_HISTORY_COUNT; i++)
+			this->heights[i] = this->sampleHeight(0.0f);
+	}
+
+	int PerfGraph::samples()
+	{
+		return this->count < GRAPH_HISTORY_COUNT ? (int)this->count : GRAPH_HISTORY_COUNT;
 	}
 
 	float PerfGraph::graphAverage()
 	{
-		int i;
-		float avg = 0;
-		for (i = 0; i < GRAPH_HISTORY_COUNT; i++)
-			avg += this->values[i];
-		return avg / (float)GRAPH_HISTORY_COUNT;
+		int n = this->samples();
+		return n ? (float)(this->sum / n) : 0.0f;
+	}
+
+	// Drops expired entries from the front and dominated ones from the
+	// back, so the front is always the extremum of the window
+	void PerfGraph::pushExtremum(ExtremumQueue& queue, float value, bool keepMax)
+	{
+		while (queue.size && queue.items[queue.first].seq + GRAPH_HISTORY_COUNT <= this->count)
+		{
+			queue.first = (queue.first+1) % GRAPH_HISTORY_COUNT;
+			queue.size--;
+		}
+
+		while (queue.size)
+		{
+			float back = queue.items[(queue.first+queue.size-1) % GRAPH_HISTORY_COUNT].value;
+			if (keepMax ? back > value : back < value)
+				break;
+			queue.size--;
+		}
+
+		queue.items[(queue.first+queue.size) % GRAPH_HISTORY_COUNT] = { this->count, value };
+		queue.size++;
 	}
 
 	void PerfGraph::update(float frameTime)
 	{
+		int bucket = histogramBucket(frameTime);
+
 		this->head = (this->head+1) % GRAPH_HISTORY_COUNT;
+
+		if (this->count >= GRAPH_HISTORY_COUNT)
+		{
+			this->sum -= this->values[this->head];
+			this->histogram[this->buckets[this->head]]--;
+		}
+
 		this->values[this->head] = frameTime;
+		this->heights[this->head] = this->sampleHeight(frameTime);
+		this->buckets[this->head] = (uint8_t)bucket;
+		this->histogram[bucket]++;
+		this->sum += frameTime;
+
+		this->pushExtremum(this->minQueue, frameTime, false);
+		this->pushExtremum(this->maxQueue, frameTime, true);
+		this->count++;
+	}
+
+	// Value below which a fraction p (0..1) of the window falls
+	float PerfGraph::percentile(float p)
+	{
+		int n = this->samples();
+		int rank, seen, i;
+		float lo, hi, v;
+
+		if (!n)
+			return 0.0f;
+
+		lo = this->minQueue.items[this->minQueue.first].value;
+		hi = this->maxQueue.items[this->maxQueue.first].value;
+
+		rank = (int)ceilf(p * n);
+		if (rank < 1)
+			rank = 1;
+
+		seen = 0;
+		for (i = 0; i < GRAPH_HISTOGRAM_BUCKETS - 1; i++)
+		{
+			seen += this->histogram[i];
+			if (seen >= rank)
+				break;
+		}
+
+		v = histogramBound(i);
+		if (v < lo) v = lo;
+		if (v > hi) v = hi;
+		return v;
+	}
+
+	PerfStats PerfGraph::getStats()
+	{
+		PerfStats stats = {};
+
+		if (!this->count)
+			return stats;
+
+		stats.average = this->graphAverage();
+		stats.min = this->minQueue.items[this->minQueue.first].value;
+		stats.max = this->maxQueue.items[this->maxQueue.first].value;
+		stats.p50 = this->percentile(0.50f);
+		stats.p95 = this->percentile(0.95f);
+		stats.p99 = this->percentile(0.99f);
+		return stats;
+	}
+
+	float PerfGraph::sampleHeight(float value)
+	{
+		float v;
+
+		switch (this->style)
+		{
+		case RenderStyle::FPS:
+			v = 1.0f / (0.00001f + value);
+			return (v > 80.0f ? 80.0f : v) / 80.0f;
+
+		case RenderStyle::PERCENT:
+			return (value > 100.0f ? 100.0f : value) / 100.0f;
+
+		case RenderStyle::PACING:
+			v = value * GRAPH_VSYNC_RATE;
+			return (v > 4.0f ? 4.0f : v) / 4.0f;
+
+		case RenderStyle::COUNT:
+			return (value > 100.0f ? 100.0f : value) / 100.0f;
+
+		default:
+			v = value * 1000.0f;
+			return (v > 20.0f ? 20.0f : v) / 20.0f;
+		}
 	}
 
 	void PerfGraph::nextStyle()
 	{
+		int i;
+
 		switch (this->style)
 		{
 		case RenderStyle::FPS:
@@ -40,92 +179,181 @@ namespace eXUI
 			this->style = RenderStyle::FPS;
 			break;
 
+		// Pacing and count graphs only make sense for their own samples
+		case RenderStyle::PACING:
+		case RenderStyle::COUNT:
 		default:
 			break;
 		}
+
+		for (i = 0; i < GRAPH_HISTORY_COUNT; i++)
+			this->heights[i] = this->sampleHeight(this->values[i]);
+		this->valueKey = this->detailKey = this->tailKey[0] = this->tailKey[1] = -1;
+	}
+
+	// Stores v quantized to the displayed precision, returns whether
+	// the displayed text changes
+	static bool requantize(long& key, float v, float scale)
+	{
+		long q = lroundf(v * scale);
+
+		if (q == key)
+			return false;
+
+		key = q;
+		return true;
+	}
+
+	void PerfGraph::refreshText()
+	{
+		float avg = this->graphAverage();
+		PerfStats stats;
+
+		if (this->style == RenderStyle::FPS) {
+			if (requantize(this->valueKey, 1.0f / avg, 100.0f))
+				snprintf(this->valueText, sizeof(this->valueText), "%.2f FPS", 1.0f / avg);
+			if (requantize(this->detailKey, avg, 100000.0f))
+				snprintf(this->detailText, sizeof(this->detailText), "%.2f ms", avg * 1000.0f);
+		}
+		else if (this->style == RenderStyle::PACING) {
+			int i, missed = 0;
+
+			// unfilled slots are zero and never count
+			for (i = 0; i < GRAPH_HISTORY_COUNT; i++)
+				if (this->values[i] * GRAPH_VSYNC_RATE > 1.5f)
+					missed++;
+
+			if (requantize(this->valueKey, (float)missed, 1.0f))
+				snprintf(this->valueText, sizeof(this->valueText), "%d missed", missed);
+			this->detailText[0] = '\0';
+		}
+		else if (this->style == RenderStyle::PERCENT) {
+			if (requantize(this->valueKey, avg, 10.0f))
+				snprintf(this->valueText, sizeof(this->valueText), "%.1f %%", avg * 1.0f);
+			this->detailText[0] = '\0';
+		}
+		else if (this->style == RenderStyle::COUNT) {
+			if (requantize(this->valueKey, avg, 10.0f))
+				snprintf(this->valueText, sizeof(this->valueText), "%.1f", avg);
+			this->detailText[0] = '\0';
+		} else {
+			if (requantize(this->valueKey, avg, 100000.0f))
+				snprintf(this->valueText, sizeof(this->valueText), "%.2f ms", avg * 1000.0f);
+			this->detailText[0] = '\0';
+		}
+
+		// Tail latency, which the average hides
+		stats = this->getStats();
+		if (this->style == RenderStyle::PERCENT) {
+			if (requantize(this->tailKey[0], stats.p99, 10.0f) | requantize(this->tailKey[1], stats.max, 10.0f))
+				snprintf(this->tailText, sizeof(this->tailText), "p99 %.1f %%  max %.1f %%", stats.p99, stats.max);
+		}
+		else if (this->style == RenderStyle::COUNT) {
+			if (requantize(this->tailKey[0], stats.p99, 1.0f) | requantize(this->tailKey[1], stats.max, 1.0f))
+				snprintf(this->tailText, sizeof(this->tailText), "p99 %.0f  max %.0f", stats.p99, stats.max);
+		} else {
+			if (requantize(this->tailKey[0], stats.p99, 10000.0f) | requantize(this->tailKey[1], stats.max, 10000.0f))
+				snprintf(this->tailText, sizeof(this->tailText), "p99 %.1f  max %.1f ms", stats.p99 * 1000.0f, stats.max * 1000.0f);
+		}
 	}
 
 	void PerfGraph::render(NVGcontext* vg, float x, float y)
 	{
-		int i;
-		float avg, w, h;
-		char str[64];
+		PerfOverlay::Entry entry = { this, x, y };
+
+		PerfOverlay::render(vg, &entry, 1);
+	}
+
+	void PerfOverlay::clear()
+	{
+		this->entries.clear();
+	}
+
+	void PerfOverlay::add(PerfGraph* graph, float x, float y)
+	{
+		this->entries.push_back({ graph, x, y });
+	}
 
-		avg = this->graphAverage();
+	void PerfOverlay::render(NVGcontext* vg)
+	{
+		PerfOverlay::render(vg, this->entries.data(), this->entries.size());
+	}
 
-		w = 200;
-		h = 35;
+	void PerfOverlay::damage(DamageTracker& tracker)
+	{
+		for (const Entry& e : this->entries)
+			tracker.add(e.x, e.y, GRAPH_WIDTH, GRAPH_HEIGHT);
+	}
+
+	void PerfOverlay::render(NVGcontext* vg, const DamageRect& clip)
+	{
+		this->visible.clear();
+		for (const Entry& e : this->entries) {
+			if (e.x < clip.x + clip.w && clip.x < e.x + GRAPH_WIDTH && e.y < clip.y + clip.h && clip.y < e.y + GRAPH_HEIGHT)
+				this->visible.push_back(e);
+		}
+
+		PerfOverlay::render(vg, this->visible.data(), this->visible.size());
+	}
+
+	void PerfOverlay::render(NVGcontext* vg, const Entry* entries, size_t count)
+	{
+		const Entry* end = entries + count;
+		const float w = GRAPH_WIDTH, h = GRAPH_HEIGHT;
+		const float step = w / (GRAPH_HISTORY_COUNT-1);
+		int i;
+
+		if (!count)
+			return;
 
 		nvgBeginPath(vg);
-		nvgRect(vg, x,y, w,h);
+		for (const Entry* e = entries; e < end; e++)
+			nvgRect(vg, e->x,e->y, w,h);
 		nvgFillColor(vg, nvgRGBA(0,0,0,128));
 		nvgFill(vg);
 
+		// One sub-path per graph, oldest sample first
 		nvgBeginPath(vg);
-		nvgMoveTo(vg, x, y+h);
-		if (this->style == RenderStyle::FPS) {
-			for (i = 0; i < GRAPH_HISTORY_COUNT; i++) {
-				float v = 1.0f / (0.00001f + this->values[(this->head+i) % GRAPH_HISTORY_COUNT]);
-				float vx, vy;
-				if (v > 80.0f) v = 80.0f;
-				vx = x + ((float)i/(GRAPH_HISTORY_COUNT-1)) * w;
-				vy = y + h - ((v / 80.0f) * h);
-				nvgLineTo(vg, vx, vy);
-			}
-		} else if (this->style == RenderStyle::PERCENT) {
-			for (i = 0; i < GRAPH_HISTORY_COUNT; i++) {
-				float v = this->values[(this->head+i) % GRAPH_HISTORY_COUNT] * 1.0f;
-				float vx, vy;
-				if (v > 100.0f) v = 100.0f;
-				vx = x + ((float)i/(GRAPH_HISTORY_COUNT-1)) * w;
-				vy = y + h - ((v / 100.0f) * h);
-				nvgLineTo(vg, vx, vy);
-			}
-		} else {
-			for (i = 0; i < GRAPH_HISTORY_COUNT; i++) {
-				float v = this->values[(this->head+i) % GRAPH_HISTORY_COUNT] * 1000.0f;
-				float vx, vy;
-				if (v > 20.0f) v = 20.0f;
-				vx = x + ((float)i/(GRAPH_HISTORY_COUNT-1)) * w;
-				vy = y + h - ((v / 20.0f) * h);
-				nvgLineTo(vg, vx, vy);
-			}
+		for (const Entry* e = entries; e < end; e++) {
+			PerfGraph* g = e->graph;
+			float base = e->y + h;
+
+			nvgMoveTo(vg, e->x, base);
+			for (i = 0; i < GRAPH_HISTORY_COUNT; i++)
+				nvgLineTo(vg, e->x + i * step, base - g->heights[(g->head+1+i) % GRAPH_HISTORY_COUNT] * h);
+			nvgLineTo(vg, e->x+w, base);
+			nvgClosePath(vg);
 		}
-		nvgLineTo(vg, x+w, y+h);
 		nvgFillColor(vg, nvgRGBA(255,192,0,128));
 		nvgFill(vg);
 
+		for (const Entry* e = entries; e < end; e++)
+			e->graph->refreshText();
+
 		nvgFontFace(vg, "switch-standard");
+
 		nvgFontSize(vg, 12.0f);
 		nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_TOP);
 		nvgFillColor(vg, nvgRGBA(240,240,240,192));
-		nvgText(vg, x+3,y+3, this->name.c_str(), NULL);
+		for (const Entry* e = entries; e < end; e++)
+			nvgText(vg, e->x+3,e->y+3, e->graph->name.c_str(), NULL);
 
-		if (this->style == RenderStyle::FPS) {
-			nvgFontSize(vg, 15.0f);
-			nvgTextAlign(vg,NVG_ALIGN_RIGHT|NVG_ALIGN_TOP);
-			nvgFillColor(vg, nvgRGBA(240,240,240,255));
-			sprintf(str, "%.2f FPS", 1.0f / avg);
-			nvgText(vg, x+w-3,y+3, str, NULL);
-
-			nvgFontSize(vg, 13.0f);
-			nvgTextAlign(vg,NVG_ALIGN_RIGHT|NVG_ALIGN_BASELINE);
-			nvgFillColor(vg, nvgRGBA(240,240,240,160));
-			sprintf(str, "%.2f ms", avg * 1000.0f);
-			nvgText(vg, x+w-3,y+h-3, str, NULL);
-		}
-		else if (this->style == RenderStyle::PERCENT) {
-			nvgFontSize(vg, 15.0f);
-			nvgTextAlign(vg,NVG_ALIGN_RIGHT|NVG_ALIGN_TOP);
-			nvgFillColor(vg, nvgRGBA(240,240,240,255));
-			sprintf(str, "%.1f %%", avg * 1.0f);
-			nvgText(vg, x+w-3,y+3, str, NULL);
-		} else {
-			nvgFontSize(vg, 15.0f);
-			nvgTextAlign(vg,NVG_ALIGN_RIGHT|NVG_ALIGN_TOP);
-			nvgFillColor(vg, nvgRGBA(240,240,240,255));
-			sprintf(str, "%.2f ms", avg * 1000.0f);
-			nvgText(vg, x+w-3,y+3, str, NULL);
-		}
+		nvgFontSize(vg, 15.0f);
+		nvgTextAlign(vg,NVG_ALIGN_RIGHT|NVG_ALIGN_TOP);
+		nvgFillColor(vg, nvgRGBA(240,240,240,255));
+		for (const Entry* e = entries; e < end; e++)
+			nvgText(vg, e->x+w-3,e->y+3, e->graph->valueText, NULL);
+
+		nvgFontSize(vg, 13.0f);
+		nvgTextAlign(vg,NVG_ALIGN_RIGHT|NVG_ALIGN_BASELINE);
+		nvgFillColor(vg, nvgRGBA(240,240,240,160));
+		for (const Entry* e = entries; e < end; e++)
+			if (e->graph->detailText[0])
+				nvgText(vg, e->x+w-3,e->y+h-3, e->graph->detailText, NULL);
+
+		nvgFontSize(vg, 11.0f);
+		nvgTextAlign(vg,NVG_ALIGN_LEFT|NVG_ALIGN_BASELINE);
+		for (const Entry* e = entries; e < end; e++)
+			nvgText(vg, e->x+3,e->y+h-3, e->graph->tailText, NULL);
 	}
 } // namespace eXUI
\ No newline at end of file
@@ -0,0 +1,146 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/profiler.hpp"
+#include "eXUI/trace.hpp"
+
+namespace eXUI
+{
+    static ProfilerZone profiler_zones[PROFILER_MAX_ZONES];
+    static int profiler_zone_count = 0;
+
+    /* Zones currently entered, innermost last */
+    static int profiler_stack[PROFILER_MAX_DEPTH];
+    static int profiler_depth = 0;
+
+    /* Whether a "frame" span is open in the current trace capture */
+    static bool profiler_frame_traced = false;
+
+    int Profiler::registerZone(const char* name)
+    {
+        ProfilerZone* zone;
+
+        if (profiler_zone_count >= PROFILER_MAX_ZONES)
+            return -1;
+
+        zone             = &profiler_zones[profiler_zone_count];
+        zone->name       = name;
+        zone->parent     = -2; /* resolved on first enter */
+        zone->depth      = 0;
+        zone->head       = 0;
+        zone->frameTicks = 0;
+        zone->frameCalls = 0;
+        zone->graph      = new PerfGraph(RenderStyle::MS, name);
+
+        return profiler_zone_count++;
+    }
+
+    void Profiler::enter(int zone)
+    {
+        ProfilerZone* z;
+
+        if (zone < 0)
+            return;
+
+        z = &profiler_zones[zone];
+        if (z->parent == -2)
+        {
+            z->parent = profiler_depth ? profiler_stack[profiler_depth - 1] : -1;
+            z->depth  = profiler_depth;
+        }
+
+        if (profiler_depth < PROFILER_MAX_DEPTH)
+            profiler_stack[profiler_depth] = zone;
+        profiler_depth++;
+
+        Trace::begin(z->name);
+    }
+
+    void Profiler::leave(int zone, u64 ticks)
+    {
+        if (zone < 0)
+            return;
+
+        profiler_zones[zone].frameTicks += ticks;
+        profiler_zones[zone].frameCalls++;
+        profiler_depth--;
+
+        Trace::end(profiler_zones[zone].name);
+    }
+
+    void Profiler::endFrame()
+    {
+        int i;
+
+        for (i = 0; i < profiler_zone_count; i++)
+        {
+            ProfilerZone* z = &profiler_zones[i];
+            u64 ns          = armTicksToNs(z->frameTicks);
+
+            z->head = (z->head + 1) % GRAPH_HISTORY_COUNT;
+            z->history[z->head].ns    = ns;
+            z->history[z->head].calls = z->frameCalls;
+            z->graph->update(ns / 1000000000.0f);
+
+            z->frameTicks = 0;
+            z->frameCalls = 0;
+        }
+
+        if (profiler_frame_traced)
+            Trace::end("frame");
+        Trace::begin("frame");
+        profiler_frame_traced = Trace::isActive();
+    }
+
+    int Profiler::getZoneCount()
+    {
+        return profiler_zone_count;
+    }
+
+    const ProfilerZone* Profiler::getZone(int zone)
+    {
+        if (zone < 0 || zone >= profiler_zone_count)
+            return nullptr;
+
+        return &profiler_zones[zone];
+    }
+
+    /* Lays `parent`'s children out depth first, returns the next free y */
+    static float profiler_layout_children(PerfOverlay& overlay, int parent, float x, float y)
+    {
+        int i;
+
+        for (i = 0; i < profiler_zone_count; i++)
+        {
+            ProfilerZone* z = &profiler_zones[i];
+
+            if (z->parent != parent)
+                continue;
+
+            overlay.add(z->graph, x + z->depth * 10.0f, y);
+            y = profiler_layout_children(overlay, i, x, y + GRAPH_HEIGHT + 5.0f);
+        }
+
+        return y;
+    }
+
+    void Profiler::layout(PerfOverlay& overlay, float x, float y)
+    {
+        profiler_layout_children(overlay, -1, x, y);
+    }
+} // namespace eXUI
@@ -0,0 +1,199 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/resolution_governor.hpp"
+#include "eXUI/logger.hpp"
+#include "eXUI/trace.hpp"
+#include <algorithm>
+
+namespace eXUI
+{
+    ResolutionGovernor::ResolutionGovernor(u64 budget)
+        : m_budget(budget),
+        m_enabled(true),
+        m_graph(RenderStyle::MS, "Frame Work")
+    {
+        this->setOutput(1280, 720);
+    }
+
+    void ResolutionGovernor::setOutput(uint32_t width, uint32_t height)
+    {
+        int i;
+
+        this->m_outputWidth  = width;
+        this->m_outputHeight = height;
+        this->m_level        = 0;
+        this->m_steps        = 1;
+        this->m_first        = 0;
+
+        /* Full output first, then every smaller step */
+        for (i = (int)(sizeof(RESOLUTION_STEPS) / sizeof(RESOLUTION_STEPS[0])) - 1; i >= 0 && RESOLUTION_STEPS[i] < height; i--)
+        {
+            this->m_first = i;
+            this->m_steps++;
+        }
+
+        this->m_frames       = 0;
+        this->m_lastChange   = 0;
+        this->m_lastUp       = 0;
+        this->m_missedBase   = 0;
+        this->m_window       = 0;
+        this->m_upCooldown   = RESOLUTION_UP_COOLDOWN;
+        this->m_historyHead  = 0;
+        this->m_historyCount = 0;
+    }
+
+    // Called whenever FramePacer::setVsyncPeriod() resets its counters
+    void ResolutionGovernor::setBudget(u64 budget)
+    {
+        this->m_budget     = budget;
+        this->m_missedBase = 0;
+    }
+
+    // Disabling keeps the current size, setOutput() goes back to full
+    void ResolutionGovernor::setEnabled(bool enabled)
+    {
+        this->m_enabled = enabled;
+    }
+
+    bool ResolutionGovernor::isEnabled()
+    {
+        return this->m_enabled;
+    }
+
+    uint32_t ResolutionGovernor::heightAt(int level)
+    {
+        return level == 0 ? this->m_outputHeight : RESOLUTION_STEPS[this->m_first + level - 1];
+    }
+
+    void ResolutionGovernor::step(int level, float workP95, u32 missed)
+    {
+        ResolutionDecision& decision = this->m_history[this->m_historyHead];
+
+        decision.frame        = this->m_frames;
+        decision.fromHeight   = this->heightAt(this->m_level);
+        decision.toHeight     = this->heightAt(level);
+        decision.workP95      = workP95 * 1000.0f;
+        decision.missedFrames = missed;
+        this->m_historyHead   = (this->m_historyHead + 1) % RESOLUTION_HISTORY;
+        this->m_historyCount  = std::min(this->m_historyCount + 1, RESOLUTION_HISTORY);
+
+        if (level < this->m_level)
+            this->m_lastUp = this->m_frames;
+        this->m_level      = level;
+        this->m_lastChange = this->m_frames;
+
+        EXUI_LOG_DEBUG("Render height {} -> {} (work p95 {:.2f} ms, {} missed)",
+            decision.fromHeight, decision.toHeight, decision.workP95, missed);
+#if defined(EXUI_PROFILER)
+        Trace::counter("render height", decision.toHeight);
+#endif /* EXUI_PROFILER */
+    }
+
+    bool ResolutionGovernor::update(u64 workNs, const FramePacingStats& pacing)
+    {
+        const float budget = this->m_budget / 1000000000.0f;
+        u64 since;
+        u32 missed;
+        float p95 = 0.0f, ratio;
+        bool fresh;
+
+        this->m_graph.update(workNs / 1000000000.0f);
+        this->m_frames++;
+
+        if (++this->m_window < RESOLUTION_WINDOW)
+            return false;
+
+        /* The pacer's counters restart when the swapchain is rebuilt */
+        if (pacing.missedFrames < this->m_missedBase)
+            this->m_missedBase = 0;
+        missed             = (u32)(pacing.missedFrames - this->m_missedBase);
+        this->m_missedBase = pacing.missedFrames;
+        this->m_window     = 0;
+
+        if (!this->m_enabled || this->m_steps < 2)
+            return false;
+
+        /* The work graph only speaks for this size once its whole
+         * history was recorded at it; misses are always current */
+        since = this->m_frames - this->m_lastChange;
+        fresh = since >= GRAPH_HISTORY_COUNT;
+        if (fresh)
+            p95 = this->m_graph.getStats().p95;
+
+        if (this->m_level + 1 < this->m_steps && (missed >= 2 || p95 > RESOLUTION_DOWN_LOAD * budget))
+        {
+            // The last step up did not hold: wait twice as long next time
+            if (this->m_lastUp && this->m_lastChange == this->m_lastUp && since < 2 * this->m_upCooldown)
+                this->m_upCooldown = std::min(2 * this->m_upCooldown, RESOLUTION_MAX_COOLDOWN);
+
+            this->step(this->m_level + 1, p95, missed);
+            return true;
+        }
+
+        // A step up that held for a while resets the back-off
+        if (this->m_lastChange == this->m_lastUp && since >= 2 * this->m_upCooldown)
+            this->m_upCooldown = RESOLUTION_UP_COOLDOWN;
+
+        if (this->m_level > 0 && missed == 0 && fresh && since >= this->m_upCooldown)
+        {
+            // Work is assumed to follow the pixel count
+            ratio = (float)this->heightAt(this->m_level - 1) / this->heightAt(this->m_level);
+            ratio *= ratio;
+
+            if (p95 * ratio < RESOLUTION_UP_LOAD * budget)
+            {
+                this->step(this->m_level - 1, p95, missed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint32_t ResolutionGovernor::getWidth()
+    {
+        // Same aspect as the output, rounded to an even width
+        return (uint32_t)((u64)this->m_outputWidth * this->getHeight() / this->m_outputHeight) & ~1u;
+    }
+
+    uint32_t ResolutionGovernor::getHeight()
+    {
+        return this->heightAt(this->m_level);
+    }
+
+    float ResolutionGovernor::getScale()
+    {
+        return (float)this->getHeight() / this->m_outputHeight;
+    }
+
+    PerfGraph* ResolutionGovernor::getGraph()
+    {
+        return &this->m_graph;
+    }
+
+    int ResolutionGovernor::getDecisionCount()
+    {
+        return this->m_historyCount;
+    }
+
+    const ResolutionDecision& ResolutionGovernor::getDecision(int index)
+    {
+        return this->m_history[(this->m_historyHead - 1 - index + RESOLUTION_HISTORY) % RESOLUTION_HISTORY];
+    }
+} // namespace eXUI
@@ -0,0 +1,221 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/smooth_ticker.hpp"
+#include <math.h>
+
+namespace eXUI
+{
+    static const char smooth_ticker_spacer_default[] = "   |   ";
+    static const char smooth_ticker_ellipsis[]       = "...";
+
+    /* Time spent at each end of a bouncing label, matching the two
+     * TICKER_SPEED steps the character ticker waits for */
+    #define SMOOTH_TICKER_PAUSE 666.0f
+
+    SmoothTicker::SmoothTicker(float speed)
+        : m_type(TICKER_TYPE_BOUNCE),
+        m_speed(speed),
+        m_measured(false),
+        m_font(-1),
+        m_fontSize(0.0f),
+        m_textWidth(0.0f),
+        m_spacerWidth(0.0f),
+        m_ellipsisWidth(0.0f),
+        m_time(0.0f),
+        m_selected(false)
+    {
+        this->m_spacer = smooth_ticker_spacer_default;
+    }
+
+    void SmoothTicker::setText(std::string_view str, std::string_view spacer)
+    {
+        if (spacer.empty())
+            spacer = smooth_ticker_spacer_default;
+
+        if (str == this->m_text && spacer == this->m_spacer)
+            return;
+
+        this->m_text     = str;
+        this->m_spacer   = spacer;
+        this->m_measured = false;
+        this->reset();
+    }
+
+    void SmoothTicker::setType(enum menu_animation_ticker_type type)
+    {
+        if (type == this->m_type)
+            return;
+
+        this->m_type = type;
+        this->reset();
+    }
+
+    void SmoothTicker::reset()
+    {
+        this->m_time = 0.0f;
+    }
+
+    void SmoothTicker::measure(NVGcontext* vg, int font, float fontSize)
+    {
+        const char* start = this->m_text.data();
+        const char* end   = start + this->m_text.size();
+        int count, i;
+
+        if (this->m_measured && this->m_font == font && this->m_fontSize == fontSize)
+            return;
+
+        /* at most one glyph per byte */
+        std::vector<NVGglyphPosition> positions(this->m_text.size());
+
+        /* callers set the same font state before drawing */
+        this->m_textWidth     = nvgTextBounds(vg, 0, 0, start, end, NULL);
+        this->m_spacerWidth   = nvgTextBounds(vg, 0, 0, this->m_spacer.c_str(), NULL, NULL);
+        this->m_ellipsisWidth = nvgTextBounds(vg, 0, 0, smooth_ticker_ellipsis, NULL, NULL);
+
+        count = positions.size() > 0 ? nvgTextGlyphPositions(vg, 0, 0, start, end, positions.data(), (int)positions.size()) : 0;
+
+        this->m_glyphs.resize(count);
+        for (i = 0; i < count; i++)
+        {
+            this->m_glyphs[i].offset = (uint32_t)(positions[i].str - start);
+            this->m_glyphs[i].x      = positions[i].x;
+        }
+
+        this->m_measured = true;
+        this->m_font     = font;
+        this->m_fontSize = fontSize;
+    }
+
+    /* Scroll offset in pixels for the current time */
+    float SmoothTicker::offset(float width)
+    {
+        float distance = this->m_time * this->m_speed / 1000.0f;
+
+        if (this->m_type == TICKER_TYPE_LOOP)
+            return fmodf(distance, this->m_textWidth + this->m_spacerWidth);
+
+        /* Bounce: pause, scroll to the end, pause, scroll back */
+        {
+            float overflow = this->m_textWidth - width;
+            float travel   = overflow / this->m_speed * 1000.0f;
+            float period   = 2.0f * (SMOOTH_TICKER_PAUSE + travel);
+            float t        = fmodf(this->m_time, period);
+
+            if (t < SMOOTH_TICKER_PAUSE)
+                return 0.0f;
+            t -= SMOOTH_TICKER_PAUSE;
+
+            if (t < travel)
+                return t * this->m_speed / 1000.0f;
+            t -= travel;
+
+            if (t < SMOOTH_TICKER_PAUSE)
+                return overflow;
+            t -= SMOOTH_TICKER_PAUSE;
+
+            return overflow - t * this->m_speed / 1000.0f;
+        }
+    }
+
+    /* End of the longest glyph prefix that still fits with an ellipsis.
+     * A prefix ending before glyph k is m_glyphs[k].x wide. */
+    const char* SmoothTicker::truncate(float width)
+    {
+        float limit = width - this->m_ellipsisWidth;
+        size_t lo = 0, hi = this->m_glyphs.size();
+
+        /* first glyph starting past the limit */
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+
+            if (this->m_glyphs[mid].x <= limit)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if (lo == 0)
+            return this->m_text.data();
+
+        return this->m_text.data() + this->m_glyphs[lo - 1].offset;
+    }
+
+    bool SmoothTicker::render(NVGcontext* vg, AnimationEngine* engine, int font, float fontSize,
+        float x, float y, float width, float height, bool selected)
+    {
+        const char* text = this->m_text.c_str();
+        float cy         = y + height / 2.0f;
+        bool scrolling   = false;
+
+        nvgFontFaceId(vg, font);
+        nvgFontSize(vg, fontSize);
+        nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
+
+        this->measure(vg, font, fontSize);
+
+        if (selected != this->m_selected)
+        {
+            this->m_selected = selected;
+            this->reset();
+        }
+
+        if (this->m_textWidth <= width)
+        {
+            nvgText(vg, x, cy, text, NULL);
+            return false;
+        }
+
+        nvgSave(vg);
+        nvgIntersectScissor(vg, x, y, width, height);
+
+        if (!selected)
+        {
+            const char* end = this->truncate(width);
+            float endX      = nvgText(vg, x, cy, text, end);
+
+            nvgText(vg, endX, cy, smooth_ticker_ellipsis, NULL);
+        }
+        else
+        {
+            float scroll;
+
+            this->m_time += engine->getDeltaTime();
+            scroll = this->offset(width);
+
+            nvgText(vg, x - scroll, cy, text, NULL);
+
+            if (this->m_type == TICKER_TYPE_LOOP)
+            {
+                float spacerX = x - scroll + this->m_textWidth;
+
+                nvgText(vg, spacerX, cy, this->m_spacer.c_str(), NULL);
+                nvgText(vg, spacerX + this->m_spacerWidth, cy, text, NULL);
+            }
+
+            /* keep frames coming while the label moves */
+            engine->ctl(MENU_ANIMATION_CTL_SET_ACTIVE, NULL);
+            scrolling = true;
+        }
+
+        nvgRestore(vg);
+
+        return scrolling;
+    }
+} // namespace eXUI
@@ -0,0 +1,301 @@
+/*
+    eXUI, Nintendo Switch UI Library
+    Copyright (C) 2021 eXhumer
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eXUI/trace.hpp"
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#if defined(__SWITCH__)
+#include <switch.h>
+#endif
+
+namespace eXUI
+{
+    struct trace_event
+    {
+        uint64_t ts;      /* ns */
+        const char* name;
+        int64_t value;    /* counter value */
+        char phase;       /* B, E, i, C or M */
+        char message[TRACE_MESSAGE_SIZE];
+    };
+
+    /* Single producer (the owning thread), single consumer (the writer).
+     * Rings are never freed so the writer can walk the list unlocked. */
+    struct trace_ring
+    {
+        trace_event events[TRACE_RING_SIZE];
+        std::atomic<uint32_t> head; /* next write, owned by the producer */
+        std::atomic<uint32_t> tail; /* next read, owned by the writer */
+        std::atomic<uint32_t> dropped;
+        uint32_t tid;
+        char name[32]; /* written by the producer */
+        bool named;    /* owned by the writer */
+        trace_ring* next;
+    };
+
+    static std::atomic<trace_ring*> trace_rings = nullptr;
+    static std::atomic<uint32_t> trace_next_tid = 1;
+    static thread_local trace_ring* trace_local = nullptr;
+
+    static std::mutex trace_lock; /* start/stop only */
+    static std::thread trace_writer;
+    static std::atomic<bool> trace_running = false;
+    static FILE* trace_file = nullptr;
+    static bool trace_first = true;
+
+    static uint64_t trace_now()
+    {
+#if defined(__SWITCH__)
+        return armTicksToNs(armGetSystemTick());
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static trace_ring* trace_get_ring()
+    {
+        trace_ring* ring = trace_local;
+
+        if (ring)
+            return ring;
+
+        ring        = new trace_ring();
+        ring->tid   = trace_next_tid.fetch_add(1);
+        ring->named = false;
+        snprintf(ring->name, sizeof(ring->name), "thread %u", (unsigned)ring->tid);
+
+        ring->next = trace_rings.load();
+        while (!trace_rings.compare_exchange_weak(ring->next, ring))
+            ;
+
+        trace_local = ring;
+        return ring;
+    }
+
+    static void trace_record(char phase, const char* name, int64_t value, const char* message)
+    {
+        trace_ring* ring = trace_get_ring();
+        uint32_t head    = ring->head.load(std::memory_order_relaxed);
+        trace_event* ev;
+
+        if (head - ring->tail.load(std::memory_order_acquire) >= TRACE_RING_SIZE)
+        {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        ev        = &ring->events[head % TRACE_RING_SIZE];
+        ev->ts    = trace_now();
+        ev->name  = name;
+        ev->value = value;
+        ev->phase = phase;
+        if (message)
+            snprintf(ev->message, sizeof(ev->message), "%s", message);
+        else
+            ev->message[0] = '\0';
+
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    static void trace_write_string(const char* str)
+    {
+        fputc('"', trace_file);
+        for (; *str; str++)
+        {
+            unsigned char c = (unsigned char)*str;
+
+            if (c == '"' || c == '\\')
+                fprintf(trace_file, "\\%c", c);
+            else if (c < 0x20)
+                fprintf(trace_file, "\\u%04x", c);
+            else
+                fputc(c, trace_file);
+        }
+        fputc('"', trace_file);
+    }
+
+    static void trace_write_header(const trace_ring* ring, const char* ph, const char* name)
+    {
+        fputs(trace_first ? "\n" : ",\n", trace_file);
+        trace_first = false;
+
+        fputs("{\"name\":", trace_file);
+        trace_write_string(name);
+        fprintf(trace_file, ",\"ph\":\"%s\",\"pid\":1,\"tid\":%u", ph, (unsigned)ring->tid);
+    }
+
+    static void trace_write_event(const trace_ring* ring, const trace_event* ev)
+    {
+        char ph[2] = { ev->phase, '\0' };
+
+        trace_write_header(ring, ph, ev->name);
+        fprintf(trace_file, ",\"ts\":%llu.%03u",
+            (unsigned long long)(ev->ts / 1000), (unsigned)(ev->ts % 1000));
+
+        switch (ev->phase)
+        {
+        case 'C':
+            fprintf(trace_file, ",\"args\":{\"value\":%lld}", (long long)ev->value);
+            break;
+
+        case 'i':
+            fputs(",\"s\":\"t\",\"args\":{\"message\":", trace_file);
+            trace_write_string(ev->message);
+            fputc('}', trace_file);
+            break;
+
+        case 'M':
+            fputs(",\"args\":{\"name\":", trace_file);
+            trace_write_string(ev->message);
+            fputc('}', trace_file);
+            break;
+
+        default:
+            break;
+        }
+
+        fputc('}', trace_file);
+    }
+
+    /* Writer side: drains every ring into the file */
+    static void trace_drain()
+    {
+        trace_ring* ring;
+
+        for (ring = trace_rings.load(std::memory_order_acquire); ring; ring = ring->next)
+        {
+            uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint32_t head = ring->head.load(std::memory_order_acquire);
+
+            if (!ring->named && tail != head)
+            {
+                trace_write_header(ring, "M", "thread_name");
+                fputs(",\"args\":{\"name\":", trace_file);
+                trace_write_string(ring->name);
+                fputs("}}", trace_file);
+                ring->named = true;
+            }
+
+            for (; tail != head; tail++)
+                trace_write_event(ring, &ring->events[tail % TRACE_RING_SIZE]);
+
+            ring->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    static void trace_writer_main()
+    {
+        while (trace_running.load())
+        {
+            trace_drain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        trace_drain();
+    }
+
+    bool Trace::start(const char* path)
+    {
+        std::lock_guard<std::mutex> guard(trace_lock);
+        trace_ring* ring;
+
+        if (trace_file)
+            return false;
+
+        if (!(trace_file = fopen(path, "w")))
+            return false;
+
+        /* Discard anything left over from a previous capture */
+        for (ring = trace_rings.load(); ring; ring = ring->next)
+        {
+            ring->tail.store(ring->head.load());
+            ring->dropped.store(0);
+            ring->named = false;
+        }
+
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", trace_file);
+        trace_first = true;
+
+        trace_running.store(true);
+        trace_writer = std::thread(trace_writer_main);
+        Trace::active.store(true);
+
+        return true;
+    }
+
+    void Trace::stop()
+    {
+        std::lock_guard<std::mutex> guard(trace_lock);
+        uint32_t dropped = 0;
+        trace_ring* ring;
+
+        if (!trace_file)
+            return;
+
+        Trace::active.store(false);
+        trace_running.store(false);
+        trace_writer.join();
+
+        for (ring = trace_rings.load(); ring; ring = ring->next)
+            dropped += ring->dropped.load();
+
+        fprintf(trace_file, "\n],\"otherData\":{\"droppedEvents\":%u}}\n", (unsigned)dropped);
+        fclose(trace_file);
+        trace_file = nullptr;
+    }
+
+    void Trace::setThreadName(const char* name)
+    {
+        trace_ring* ring = trace_get_ring();
+
+        snprintf(ring->name, sizeof(ring->name), "%s", name);
+
+        /* the writer may have named this thread already */
+        if (Trace::isActive())
+            trace_record('M', "thread_name", 0, name);
+    }
+
+    void Trace::begin(const char* name)
+    {
+        if (Trace::isActive())
+            trace_record('B', name, 0, nullptr);
+    }
+
+    void Trace::end(const char* name)
+    {
+        if (Trace::isActive())
+            trace_record('E', name, 0, nullptr);
+    }
+
+    void Trace::instant(const char* name, const char* message)
+    {
+        if (Trace::isActive())
+            trace_record('i', name, 0, message);
+    }
+
+    void Trace::counter(const char* name, int64_t value)
+    {
+        if (Trace::isActive())
+            trace_record('C', name, value, nullptr);
+    }
+} // namespace eXUI
@@ -1,4 +1,7 @@
 #include "eXUI/ui_state.hpp"
+#include "eXUI/memory_telemetry.hpp"
+#include "eXUI/profiler.hpp"
+#include "eXUI/trace.hpp"
 
 namespace eXUI
 {
@@ -36,19 +39,35 @@ namespace eXUI
     }
 
     DkUIState::DkUIState(nvg::DkRenderer *renderer, uint32_t w, uint32_t h)
+        : m_damage(w, h)
     {
         this->m_w = w;
         this->m_h = h;
+        this->m_prevTime = 0.0f;
+        this->m_dirty = true;
+        this->m_rendered = false;
+        this->m_resumed = false;
+        this->m_region = nullptr;
+        this->m_flashDamage = false;
+        this->m_pacer = nullptr;
+        this->m_recorder = nullptr;
+        this->m_replayer = nullptr;
+        this->m_frameNs = 0;
         this->m_renderer = renderer;
         this->m_vg = nvgCreateDk(this->m_renderer, NVG_ANTIALIAS | NVG_STENCIL_STROKES);
         this->m_fontStash = new FontStash(this->m_vg);
         this->m_fps = new PerfGraph(RenderStyle::FPS, "Frame Timing");
+        // Animations run on frame time so replays step them identically
+        this->m_animations = new AnimationEngine([this]() { return (int64_t)(this->m_frameNs / 1000); });
+        AnimationEngine::setDefault(this->m_animations);
         padConfigureInput(1, HidNpadStyleSet_NpadStandard);
         padInitializeDefault(&this->m_pad);
     }
 
     DkUIState::~DkUIState()
     {
+        delete this->m_animations;
+        this->m_animations = nullptr;
         delete this->m_fps;
         this->m_fps = nullptr;
         delete this->m_fontStash;
@@ -58,33 +77,209 @@ namespace eXUI
         this->m_renderer = nullptr;
     }
 
+    // Lays out the frame and returns the area back buffer `slot` must
+    // clear and redraw, in UI units
+    const DamageRegion &DkUIState::beginFrame(unsigned slot)
+    {
+        this->m_overlay.clear();
+        this->m_overlay.add(this->m_fps, 5, 5);
+        if (this->m_pacer)
+            this->m_overlay.add(this->m_pacer->getGraph(), 10 + GRAPH_WIDTH, 5);
+        MemoryTelemetry::layout(this->m_overlay, 15 + 2 * GRAPH_WIDTH, 5);
+#if defined(EXUI_PROFILER)
+        Profiler::layout(this->m_overlay, 5, 45);
+#endif /* EXUI_PROFILER */
+        this->m_overlay.damage(this->m_damage);
+
+        this->m_region = &this->m_damage.resolve(slot);
+        return *this->m_region;
+    }
+
     void DkUIState::render(u64 ns, float fbW, float fbH)
     {
+        EXUI_PROFILE_ZONE("DkUIState::render");
         float time = ns / 1000000000.0;
         float dt = time - this->m_prevTime;
         this->m_prevTime = time;
 
-        this->m_fps->update(dt);
+        // After skipped frames dt spans the whole idle stretch, which
+        // is not a frame time
+        if (!this->m_resumed)
+            this->m_fps->update(dt);
+        this->m_resumed = false;
+        this->m_rendered = true;
+
+        // Tickers drawn below flag the engine active again if they keep scrolling
+        this->m_animations->ctl(MENU_ANIMATION_CTL_CLEAR_ACTIVE, nullptr);
+
+        // Callers that skip beginFrame() get a full redraw
+        if (!this->m_region)
+            this->beginFrame(0);
 
         nvgBeginFrame(this->m_vg, fbW, fbH, 1.0f);
         nvgScale(this->m_vg, fbW / this->m_w, fbH / this->m_h);
+
+        // The rects are disjoint, so content spanning several of them
+        // is drawn once per rect without blending over itself
+        for (int i = 0; i < this->m_region->count; i++)
+        {
+            const DamageRect &rect = this->m_region->rects[i];
+
+            nvgSave(this->m_vg);
+            nvgScissor(this->m_vg, rect.x, rect.y, rect.w, rect.h);
+            this->m_overlay.render(this->m_vg, rect);
+            nvgRestore(this->m_vg);
+        }
+
+        if (this->m_flashDamage)
+        {
+            const DamageRegion &reported = this->m_damage.getFrameDamage();
+
+            nvgBeginPath(this->m_vg);
+            for (int i = 0; i < reported.count; i++)
+            {
+                const DamageRect &rect = reported.rects[i];
+
+                nvgRect(this->m_vg, rect.x, rect.y, rect.w, rect.h);
+                // Erased next frame without being reported again
+                this->m_damage.addOverdraw(rect.x, rect.y, rect.w, rect.h);
+            }
+            nvgFillColor(this->m_vg, nvgRGBA(255, 0, 255, 96));
+            nvgFill(this->m_vg);
+        }
+
         {
-            this->m_fps->render(this->m_vg, 5, 5);
+            EXUI_PROFILE_ZONE("nvgEndFrame");
+            nvgEndFrame(this->m_vg);
         }
-        nvgEndFrame(this->m_vg);
+
+        this->m_dirty = this->m_animations->isActive() || !this->m_damage.isEmpty();
+        this->m_region = nullptr;
     }
 
     bool DkUIState::onFrame(u64 ns)
     {
-        padUpdate(&this->m_pad);
-        u64 kDown = padGetButtonsDown(&this->m_pad);
+        EXUI_PROFILE_ZONE("DkUIState::onFrame");
+        InputFrame input;
+
+        // The previous frame was skipped, or this is the first one
+        if (!this->m_rendered)
+            this->m_resumed = true;
+        this->m_rendered = false;
+
+        if (this->m_replayer)
+        {
+            // The log drives both input and time; stop at its end
+            if (!this->m_replayer->next(input))
+                return false;
+        }
+        else
+        {
+            padUpdate(&this->m_pad);
+            input.ns = ns;
+            input.down = padGetButtonsDown(&this->m_pad);
+            input.held = padGetButtons(&this->m_pad);
+            input.up = padGetButtonsUp(&this->m_pad);
+        }
+
+        if (this->m_recorder)
+            this->m_recorder->record(input);
+
+        this->m_frameNs = input.ns;
+        u64 kDown = input.down;
+
+        // Input alone damages nothing, whatever it changes reports its
+        // own area; the frame still has to be drawn to find out
+        if (input.down || input.held || input.up)
+            this->m_dirty = true;
 
         if (kDown & KEY_A)
             this->m_fps->nextStyle();
 
+        // Flashes every area redrawn because it changed
+        if (kDown & KEY_Y)
+            this->setDamageFlash(!this->m_flashDamage);
+
+#if defined(EXUI_PROFILER)
+        // Toggles a timeline capture, open the file in ui.perfetto.dev
+        if (kDown & KEY_MINUS)
+        {
+            if (Trace::isActive())
+                Trace::stop();
+            else
+                Trace::start(TraceDefaultPath);
+        }
+#endif /* EXUI_PROFILER */
+
         if (kDown & KEY_PLUS)
             return false;
 
+        // Also fires due timers, whose callbacks may invalidate()
+        if (this->m_animations->update())
+            this->invalidate();
+
         return true;
     }
+
+    AnimationEngine *DkUIState::getAnimations()
+    {
+        return this->m_animations;
+    }
+
+    // Shows the pacing graph next to frame timing
+    void DkUIState::setFramePacer(FramePacer *pacer)
+    {
+        this->m_pacer = pacer;
+    }
+
+    // Records every frame's time and input from now on, nullptr stops
+    void DkUIState::setInputRecorder(InputRecorder *recorder)
+    {
+        this->m_recorder = recorder;
+    }
+
+    // Takes time and input from a log instead of the pad, nullptr stops
+    void DkUIState::setInputReplayer(InputReplayer *replayer)
+    {
+        this->m_replayer = replayer;
+    }
+
+    // Timestamp of the current frame, recorded or replayed
+    u64 DkUIState::getFrameTime()
+    {
+        return this->m_frameNs;
+    }
+
+    // Requests a full redraw, e.g. after a model change
+    void DkUIState::invalidate()
+    {
+        this->m_damage.addFull();
+        this->m_dirty = true;
+    }
+
+    // Requests a redraw of part of the screen, in UI units
+    void DkUIState::invalidate(float x, float y, float w, float h)
+    {
+        this->m_damage.add(x, y, w, h);
+        this->m_dirty = true;
+    }
+
+    // The back buffers were recreated and hold nothing worth keeping
+    void DkUIState::invalidateBuffers()
+    {
+        this->m_damage.reset(this->m_w, this->m_h);
+        this->m_dirty = true;
+    }
+
+    void DkUIState::setDamageFlash(bool enabled)
+    {
+        this->m_flashDamage = enabled;
+        this->invalidate();
+    }
+
+    // Whether the last presented frame is out of date
+    bool DkUIState::isDirty()
+    {
+        return this->m_dirty;
+    }
 } // namespace eXUI
\ No newline at end of file